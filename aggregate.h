@@ -0,0 +1,156 @@
+//
+// Created by lehoai on 2/27/26.
+//
+
+#ifndef SIMDCSV_AGGREGATE_H
+#define SIMDCSV_AGGREGATE_H
+
+// GROUP BY one column with COUNT / SUM / MIN / MAX / AVG, see CsvReader::group_by
+// every worker keeps its own group table: a csv::Dictionary gives each key a dense code, the
+// accumulators of a group sit next to each other at code * aggregates. value fields are parsed
+// as they arrive, nothing is copied but new keys. the partial tables are merged once at the end
+//
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "decode.h"
+#include "dictionary.h"
+#include "number.h"
+
+namespace csv {
+
+    struct aggregate {
+        enum class kind { count, sum, min, max, avg };
+
+        kind op = kind::count;
+        std::string column;   // empty: count(*)
+
+        // rows of the group, or its numeric fields of column
+        static aggregate count(std::string column = {}) { return {kind::count, std::move(column)}; }
+        static aggregate sum(std::string column) { return {kind::sum, std::move(column)}; }
+        static aggregate min(std::string column) { return {kind::min, std::move(column)}; }
+        static aggregate max(std::string column) { return {kind::max, std::move(column)}; }
+        static aggregate avg(std::string column) { return {kind::avg, std::move(column)}; }
+
+        // "sum(price)", "count(*)"
+        [[nodiscard]] inline std::string name() const;
+    };
+
+    // GROUP BY key, fields that are not numbers are left out of every aggregate but count(*)
+    struct group_query {
+        std::string key;
+        std::vector<aggregate> aggregates;
+    };
+
+    struct group_row {
+        std::string key;
+        std::vector<double> values;   // one per aggregate, NaN for min / max / avg without numbers
+    };
+
+    struct group_table {
+        std::vector<std::string> columns;   // key, then aggregate names
+        std::vector<group_row> rows;        // sorted by key
+    };
+
+    namespace detail {
+        // integers take decode.h's SWAR path, everything else parse_float
+        inline bool parse_number(const std::string_view sv, double& out) {
+            int64_t i;
+            if (parse_int64(sv, i)) {
+                out = static_cast<double>(i);
+                return true;
+            }
+            return parse_float(sv, out) == parse_status::ok;
+        }
+
+        struct agg_state {
+            double sum = 0;
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+            uint64_t count = 0;
+
+            void add(const double v) {
+                sum += v;
+                min = std::min(min, v);
+                max = std::max(max, v);
+                count++;
+            }
+
+            void merge(const agg_state& other) {
+                sum += other.sum;
+                min = std::min(min, other.min);
+                max = std::max(max, other.max);
+                count += other.count;
+            }
+        };
+
+        // one worker's groups, cache line aligned so workers never share a line
+        class alignas(64) group_partial {
+        private:
+            csv::Dictionary _keys;
+            std::vector<agg_state> _states;   // code * width + aggregate
+            size_t _width = 0;
+        public:
+            explicit group_partial(const size_t width) : _width(width) {}
+
+            // accumulators of key's group
+            agg_state* group(const std::string_view key) {
+                const size_t offset = static_cast<size_t>(_keys.encode(key)) * _width;
+                if (offset == _states.size()) _states.resize(offset + _width);
+                return _states.data() + offset;
+            }
+
+            void merge(const group_partial& other) {
+                for (uint32_t code = 0; code < other._keys.size(); code++) {
+                    agg_state* into = group(other._keys.value(code));
+                    const agg_state* from = other._states.data() + static_cast<size_t>(code) * _width;
+                    for (size_t a = 0; a < _width; a++) into[a].merge(from[a]);
+                }
+            }
+
+            [[nodiscard]] inline group_table result(const group_query& query) const;
+        };
+    }
+}
+
+std::string csv::aggregate::name() const {
+    static constexpr const char* NAMES[] = {"count", "sum", "min", "max", "avg"};
+    return std::string(NAMES[static_cast<int>(op)]) + "(" + (column.empty() ? "*" : column) + ")";
+}
+
+csv::group_table csv::detail::group_partial::result(const group_query &query) const {
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+    group_table table;
+    table.columns.push_back(query.key);
+    for (const auto& agg : query.aggregates) {
+        table.columns.push_back(agg.name());
+    }
+
+    table.rows.resize(_keys.size());
+    for (uint32_t code = 0; code < _keys.size(); code++) {
+        group_row& row = table.rows[code];
+        row.key = std::string(_keys.value(code));
+        row.values.reserve(_width);
+        const agg_state* states = _states.data() + static_cast<size_t>(code) * _width;
+        for (size_t a = 0; a < _width; a++) {
+            const agg_state& s = states[a];
+            switch (query.aggregates[a].op) {
+                case aggregate::kind::count: row.values.push_back(static_cast<double>(s.count)); break;
+                case aggregate::kind::sum: row.values.push_back(s.sum); break;
+                case aggregate::kind::min: row.values.push_back(s.count ? s.min : NaN); break;
+                case aggregate::kind::max: row.values.push_back(s.count ? s.max : NaN); break;
+                case aggregate::kind::avg: row.values.push_back(s.count ? s.sum / s.count : NaN); break;
+            }
+        }
+    }
+    std::sort(table.rows.begin(), table.rows.end(),
+              [](const group_row& a, const group_row& b) { return a.key < b.key; });
+    return table;
+}
+
+#endif //SIMDCSV_AGGREGATE_H
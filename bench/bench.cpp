@@ -0,0 +1,467 @@
+//
+// Created by lehoai on 2/19/26.
+//
+// throughput of the parse, count, typed-decode, rewrite (parse + CsvWriter) and group_by paths over
+// deterministic synthetic files
+// usage: simdcsv_bench [--mb=64] [--runs=5] [--dir=<tmp>/simdcsv_bench] [--only=narrow_numeric,...]
+//                      [--io=mmap,willneed,populate,hugepage,pread,direct] [--out=file.json]
+// the parse path runs once per io policy, count and typed use the default mmap policy
+// one JSON document on stdout (or --out), progress on stderr
+//
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "csv_reader.h"
+#include "writer.h"
+
+#if SIMDCSV_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifndef SIMDCSV_VERSION
+#define SIMDCSV_VERSION "unknown"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct options {
+        size_t mb = 64;
+        int runs = 5;
+        fs::path dir = fs::temp_directory_path() / "simdcsv_bench";
+        std::string only;
+        std::string io = "mmap,willneed,populate,hugepage,pread,direct";
+        std::string out;
+    };
+
+    struct io_choice {
+        const char* name;
+        csv::io_mode mode;
+    };
+
+    const io_choice IO_MODES[] = {
+        {"mmap", csv::io_mode::mmap},
+        {"willneed", csv::io_mode::mmap_willneed},
+        {"populate", csv::io_mode::mmap_populate},
+        {"hugepage", csv::io_mode::mmap_hugepage},
+        {"pread", csv::io_mode::pread},
+        {"direct", csv::io_mode::direct},
+    };
+
+    // one synthetic file: header + rows until the target size
+    struct dataset {
+        const char* name;
+        const char* description;
+        csv::format format;
+        std::function<void(std::mt19937_64&, std::string&)> header;
+        std::function<void(std::mt19937_64&, std::string&)> row;
+    };
+
+    volatile uint64_t sink;  // keeps field reads alive
+
+    const char* const WORDS[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+                                 "india", "juliett", "kilo", "lima", "mike", "november", "oscar", "papa"};
+
+    void append_int(std::string& out, const uint64_t v) {
+        char buf[24];
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%" PRIu64, v));
+    }
+
+    void append_price(std::string& out, std::mt19937_64& rng) {
+        char buf[32];
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%02" PRIu64, rng() % 100000, rng() % 100));
+    }
+
+    void append_words(std::string& out, std::mt19937_64& rng, const size_t n) {
+        for (size_t w = 0; w < n; w++) {
+            if (w) out += ' ';
+            out += WORDS[rng() % 16];
+        }
+    }
+
+    void numbered_header(std::string& out, const int columns) {
+        for (int c = 0; c < columns; c++) {
+            if (c) out += ',';
+            out += 'c';
+            append_int(out, c);
+        }
+        out += '\n';
+    }
+
+    csv::format quoted_format(const bool unescape = false) {
+        csv::format format;
+        format.quote = '"';
+        format.unescape = unescape;
+        return format;
+    }
+
+    std::vector<dataset> datasets() {
+        std::vector<dataset> all;
+        all.push_back({"narrow_numeric", "4 numeric columns", csv::format{},
+            [](std::mt19937_64&, std::string& out) { out += "id,odometer,price,year\n"; },
+            [n = uint64_t{0}](std::mt19937_64& rng, std::string& out) mutable {
+                append_int(out, n++);
+                out += ',';
+                append_int(out, rng() % 300000);
+                out += ',';
+                append_price(out, rng);
+                out += ',';
+                append_int(out, 1990 + rng() % 35);
+                out += '\n';
+            }});
+        all.push_back({"wide_numeric", "64 numeric columns", csv::format{},
+            [](std::mt19937_64&, std::string& out) { numbered_header(out, 64); },
+            [](std::mt19937_64& rng, std::string& out) {
+                for (int c = 0; c < 64; c++) {
+                    if (c) out += ',';
+                    if (c % 2) append_price(out, rng); else append_int(out, rng() % 100000);
+                }
+                out += '\n';
+            }});
+        all.push_back({"narrow_text", "4 unquoted text columns", csv::format{},
+            [](std::mt19937_64&, std::string& out) { out += "make,model,color,state\n"; },
+            [](std::mt19937_64& rng, std::string& out) {
+                for (int c = 0; c < 4; c++) {
+                    if (c) out += ',';
+                    append_words(out, rng, 1 + rng() % 3);
+                }
+                out += '\n';
+            }});
+        all.push_back({"wide_text", "64 unquoted text columns", csv::format{},
+            [](std::mt19937_64&, std::string& out) { numbered_header(out, 64); },
+            [](std::mt19937_64& rng, std::string& out) {
+                for (int c = 0; c < 64; c++) {
+                    if (c) out += ',';
+                    append_words(out, rng, 1 + rng() % 2);
+                }
+                out += '\n';
+            }});
+        all.push_back({"quote_heavy", "8 quoted columns with delimiters and doubled quotes, unescaped",
+            quoted_format(true),
+            [](std::mt19937_64&, std::string& out) { numbered_header(out, 8); },
+            [](std::mt19937_64& rng, std::string& out) {
+                for (int c = 0; c < 8; c++) {
+                    if (c) out += ',';
+                    out += '"';
+                    append_words(out, rng, 1 + rng() % 3);
+                    switch (rng() % 4) {
+                        case 0: out += ", "; append_words(out, rng, 1); break;
+                        case 1: out += " \"\"q\"\""; break;
+                        default: break;
+                    }
+                    out += '"';
+                }
+                out += '\n';
+            }});
+        all.push_back({"embedded_newlines", "6 columns, a quoted multi-line description", quoted_format(),
+            [](std::mt19937_64&, std::string& out) { out += "id,price,make,description,state,year\n"; },
+            [n = uint64_t{0}](std::mt19937_64& rng, std::string& out) mutable {
+                append_int(out, n++);
+                out += ',';
+                append_price(out, rng);
+                out += ',';
+                append_words(out, rng, 1);
+                out += ",\"";
+                for (uint64_t line = 0, lines = 1 + rng() % 4; line < lines; line++) {
+                    if (line) out += '\n';
+                    append_words(out, rng, 2 + rng() % 6);
+                }
+                out += "\",";
+                append_words(out, rng, 1);
+                out += ',';
+                append_int(out, 1990 + rng() % 35);
+                out += '\n';
+            }});
+        all.push_back({"ragged", "8 header columns, rows of 1 to 12 fields", csv::format{},
+            [](std::mt19937_64&, std::string& out) { numbered_header(out, 8); },
+            [](std::mt19937_64& rng, std::string& out) {
+                for (uint64_t c = 0, fields = 1 + rng() % 12; c < fields; c++) {
+                    if (c) out += ',';
+                    if (rng() % 2) append_int(out, rng() % 100000); else append_words(out, rng, 1);
+                }
+                out += '\n';
+            }});
+        all.push_back({"long_fields", "3 columns, quoted fields of 1 to 16KB", quoted_format(),
+            [](std::mt19937_64&, std::string& out) { out += "id,body,tail\n"; },
+            [n = uint64_t{0}](std::mt19937_64& rng, std::string& out) mutable {
+                append_int(out, n++);
+                out += ",\"";
+                const size_t target = out.size() + 1024 + rng() % (15 * 1024);
+                while (out.size() < target) {
+                    append_words(out, rng, 8);
+                    out += rng() % 8 ? ", " : "\n";
+                }
+                out += "\",";
+                append_words(out, rng, 1);
+                out += '\n';
+            }});
+        return all;
+    }
+
+    // write the file once, later runs reuse it when the size matches
+    fs::path generate(const dataset& set, const options& opt) {
+        const fs::path path = opt.dir / (std::string(set.name) + "_" + std::to_string(opt.mb) + "mb.csv");
+        const size_t target = opt.mb * 1024 * 1024;
+        std::error_code ec;
+        if (fs::exists(path, ec) && fs::file_size(path, ec) >= target) {
+            return path;
+        }
+        std::fprintf(stderr, "generating %s\n", path.string().c_str());
+        std::mt19937_64 rng(20260219);
+        std::FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot create " + path.string());
+        }
+        std::string buffer;
+        set.header(rng, buffer);
+        size_t written = 0;
+        while (written + buffer.size() < target) {
+            set.row(rng, buffer);
+            if (buffer.size() >= (1 << 20)) {
+                written += std::fwrite(buffer.data(), 1, buffer.size(), file);
+                buffer.clear();
+            }
+        }
+        written += std::fwrite(buffer.data(), 1, buffer.size(), file);
+        std::fclose(file);
+#ifndef _WIN32
+        // dirty pages can't be dropped by drop_cache()
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+#endif
+        return path;
+    }
+
+    // evict the file from the page cache; false when the platform can't
+    bool drop_cache(const fs::path& path) {
+#ifndef _WIN32
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        const bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        close(fd);
+        return ok;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    // invariant TSC ticks, 0 off x86
+    uint64_t cycles() {
+#if SIMDCSV_X86
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    struct sample {
+        double seconds;
+        uint64_t cycles;
+        uint64_t rows;
+    };
+
+    struct result {
+        const char* path;
+        const char* io;
+        const char* cache;
+        std::vector<sample> runs;   // sorted by time
+    };
+
+    template <typename Run>
+    result measure(const char* path_name, const char* io, const bool cold, const fs::path& file, const int runs,
+                   const Run& run) {
+        result out{path_name, io, cold ? "cold" : "warm", {}};
+        if (cold && !drop_cache(file)) {
+            return out;
+        }
+        if (!cold) {
+            run();  // fault the file in
+        }
+        for (int i = 0; i < runs; i++) {
+            if (cold) drop_cache(file);
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t c0 = cycles();
+            const uint64_t rows = run();
+            const uint64_t c1 = cycles();
+            const auto stop = std::chrono::steady_clock::now();
+            out.runs.push_back({std::chrono::duration<double>(stop - start).count(), c1 - c0, rows});
+        }
+        std::sort(out.runs.begin(), out.runs.end(),
+                  [](const sample& a, const sample& b) { return a.seconds < b.seconds; });
+        return out;
+    }
+
+    void print_result(std::FILE* out, const result& r, const uint64_t bytes, const bool last) {
+        std::fprintf(out, "        {\"path\": \"%s\", \"io\": \"%s\", \"cache\": \"%s\", ", r.path, r.io, r.cache);
+        if (r.runs.empty()) {
+            std::fprintf(out, "\"skipped\": true}%s\n", last ? "" : ",");
+            return;
+        }
+        // the median is reported for tracking, the best run alongside it
+        const sample& median = r.runs[r.runs.size() / 2];
+        std::fprintf(out, "\"runs\": %zu, \"rows\": %" PRIu64 ", \"seconds\": %.6f, \"best_seconds\": %.6f, "
+                          "\"gb_per_s\": %.4f, \"rows_per_s\": %.0f, ",
+                     r.runs.size(), median.rows, median.seconds, r.runs.front().seconds,
+                     static_cast<double>(bytes) / median.seconds / 1e9,
+                     static_cast<double>(median.rows) / median.seconds);
+        if (median.cycles != 0) {
+            std::fprintf(out, "\"cycles_per_byte\": %.4f}", static_cast<double>(median.cycles) / static_cast<double>(bytes));
+        } else {
+            std::fprintf(out, "\"cycles_per_byte\": null}");
+        }
+        std::fprintf(out, "%s\n", last ? "" : ",");
+    }
+
+    // name is in the comma separated list, an empty list holds everything
+    bool listed(const std::string& list, const char* name) {
+        if (list.empty()) return true;
+        return ("," + list + ",").find("," + std::string(name) + ",") != std::string::npos;
+    }
+
+    options parse_args(const int argc, char** argv) {
+        options opt;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            const size_t eq = arg.find('=');
+            const std::string key = arg.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            if (key == "--mb") opt.mb = std::strtoull(value.c_str(), nullptr, 10);
+            else if (key == "--runs") opt.runs = std::max(1, std::atoi(value.c_str()));
+            else if (key == "--dir") opt.dir = value;
+            else if (key == "--only") opt.only = value;
+            else if (key == "--io") opt.io = value;
+            else if (key == "--out") opt.out = value;
+            else {
+                std::fprintf(stderr, "usage: %s [--mb=N] [--runs=N] [--dir=DIR] [--only=a,b] [--io=a,b] [--out=FILE]\n", argv[0]);
+                std::exit(arg == "--help" ? 0 : 2);
+            }
+        }
+        if (opt.mb == 0) opt.mb = 1;
+        return opt;
+    }
+}
+
+int main(int argc, char** argv) {
+    const options opt = parse_args(argc, argv);
+    fs::create_directories(opt.dir);
+
+    std::FILE* out = opt.out.empty() ? stdout : std::fopen(opt.out.c_str(), "w");
+    if (out == nullptr) {
+        std::fprintf(stderr, "Cannot open %s\n", opt.out.c_str());
+        return 1;
+    }
+
+    std::fprintf(out, "{\n  \"simdcsv\": \"%s\",\n  \"kernel\": \"%s\",\n  \"mb\": %zu,\n  \"runs\": %d,\n"
+                      "  \"datasets\": [\n",
+                 SIMDCSV_VERSION, csv::simd::active().name, opt.mb, opt.runs);
+
+    std::vector<dataset> sets = datasets();
+    sets.erase(std::remove_if(sets.begin(), sets.end(), [&](const dataset& d) { return !listed(opt.only, d.name); }),
+               sets.end());
+    for (size_t s = 0; s < sets.size(); s++) {
+        const dataset& set = sets[s];
+        const fs::path file = generate(set, opt);
+        const std::string path = file.string();
+        const uint64_t bytes = fs::file_size(file);
+
+        // typed decoding runs on the schema a sampled pass infers, like a caller without one would
+        const csv::schema schema = csv::CsvReader(path.c_str(), set.format).infer().schema();
+
+        csv::io_policy io;
+        const auto parse = [&]() -> uint64_t {
+            uint64_t rows = 0, sum = 0;
+            csv::CsvReader reader(path.c_str(), set.format, io);
+            reader.parse([&](const std::string_view* row) {
+                rows++;
+                sum += row[0].size();
+            });
+            sink = sum;
+            return rows;
+        };
+        const auto count = [&]() -> uint64_t {
+            csv::CsvReader reader(path.c_str(), set.format);
+            return reader.count_rows().rows;
+        };
+        const auto typed = [&]() -> uint64_t {
+            uint64_t rows = 0;
+            csv::CsvReader reader(path.c_str(), set.format);
+            reader.parse_typed(schema, 64 * 1024, [&](const csv::TypedBatch& batch) { rows += batch.rows(); });
+            return rows;
+        };
+        // round trip: unescaped fields are quoted again on the way out
+        const std::string rewritten = (opt.dir / "rewrite.csv").string();
+        const auto rewrite = [&]() -> uint64_t {
+            uint64_t rows = 0;
+            csv::format format = set.format;
+            format.unescape = true;
+            csv::CsvReader reader(path.c_str(), format);
+            csv::CsvWriter writer(rewritten.c_str(), format);
+            const size_t cols = reader.getHeaders().size();
+            writer.write_row(reader.getHeaders());
+            reader.parse([&](const std::string_view* row) {
+                writer.write_row(row, cols);
+                rows++;
+            });
+            writer.flush();
+            return rows;
+        };
+
+        // GROUP BY the last column, count(*) and sum of the first one on every core
+        const auto group_by = [&]() -> uint64_t {
+            csv::CsvReader reader(path.c_str(), set.format);
+            const std::vector<std::string> headers = reader.getHeaders();
+            const csv::group_table table = reader.group_by(
+                {headers.back(), {csv::aggregate::count(), csv::aggregate::sum(headers.front())}});
+            uint64_t rows = 0;
+            for (const auto& row : table.rows) rows += static_cast<uint64_t>(row.values[0]);
+            return rows;
+        };
+
+        std::vector<result> results;
+        for (const bool cold : {false, true}) {
+            std::fprintf(stderr, "%s: %s cache\n", set.name, cold ? "cold" : "warm");
+            for (const io_choice& choice : IO_MODES) {
+                if (!listed(opt.io, choice.name)) continue;
+                io.mode = choice.mode;
+                results.push_back(measure("parse", choice.name, cold, file, opt.runs, parse));
+            }
+            results.push_back(measure("count", "mmap", cold, file, opt.runs, count));
+            results.push_back(measure("typed", "mmap", cold, file, opt.runs, typed));
+            results.push_back(measure("rewrite", "mmap", cold, file, opt.runs, rewrite));
+            results.push_back(measure("group_by", "mmap", cold, file, opt.runs, group_by));
+        }
+        fs::remove(rewritten);
+
+        std::fprintf(out, "    {\"name\": \"%s\", \"description\": \"%s\", \"bytes\": %" PRIu64 ", \"results\": [\n",
+                     set.name, set.description, bytes);
+        for (size_t r = 0; r < results.size(); r++) {
+            print_result(out, results[r], bytes, r + 1 == results.size());
+        }
+        std::fprintf(out, "    ]}%s\n", s + 1 == sets.size() ? "" : ",");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,86 @@
+//
+// Created by lehoai on 2/12/26.
+//
+// cost per field of csv::get<double>/<float> against std::from_chars
+// usage: simdcsv_float_bench [fields]
+//
+#include <charconv>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_reader.h"
+
+namespace {
+    // deterministic fields shaped like real columns
+    std::vector<std::string> make_fields(const std::string& kind, const size_t n) {
+        std::mt19937_64 rng(12345);
+        std::vector<std::string> fields;
+        fields.reserve(n);
+        char buf[64];
+        for (size_t i = 0; i < n; i++) {
+            if (kind == "price") {          // 12345.67
+                std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%02" PRIu64, rng() % 100000, rng() % 100);
+            } else if (kind == "odometer") {  // 123456
+                std::snprintf(buf, sizeof(buf), "%" PRIu64, rng() % 300000);
+            } else if (kind == "coordinate") {  // -122.419416
+                std::snprintf(buf, sizeof(buf), "%.6f", static_cast<double>(rng() % 360000000) / 1e6 - 180);
+            } else if (kind == "scientific") {  // 6.02214076e23
+                std::snprintf(buf, sizeof(buf), "%.8e", static_cast<double>(rng() % 1000000) * 1e-3
+                              * (rng() % 2 ? 1e20 : 1e-20));
+            } else {  // full precision round trip
+                uint64_t bits = rng() & 0x7FEFFFFFFFFFFFFFull;
+                double d;
+                std::memcpy(&d, &bits, 8);
+                std::snprintf(buf, sizeof(buf), "%.17g", d);
+            }
+            fields.emplace_back(buf);
+        }
+        return fields;
+    }
+
+    template <typename F>
+    double ns_per_field(const std::vector<std::string>& fields, const F& parse) {
+        double best = 1e30;
+        for (int round = 0; round < 5; round++) {
+            const auto start = std::chrono::steady_clock::now();
+            double sum = 0;
+            for (const auto& f : fields) {
+                sum += parse(std::string_view(f));
+            }
+            const auto stop = std::chrono::steady_clock::now();
+            // keep the sum alive
+            if (sum == 0.123) std::printf(" ");
+            best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / fields.size());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::printf("%-12s %12s %12s %12s %12s\n", "kind", "get<double>", "from_chars", "get<float>", "from_chars");
+    for (const char* kind : {"price", "odometer", "coordinate", "scientific", "roundtrip"}) {
+        const auto fields = make_fields(kind, n);
+        const double fast = ns_per_field(fields, [](std::string_view sv) { return csv::get<double>(sv); });
+        const double ref = ns_per_field(fields, [](std::string_view sv) {
+            double v = 0;
+            std::from_chars(sv.data(), sv.data() + sv.size(), v);
+            return v;
+        });
+        const double fast_f = ns_per_field(fields, [](std::string_view sv) { return csv::get<float>(sv); });
+        const double ref_f = ns_per_field(fields, [](std::string_view sv) {
+            float v = 0;
+            std::from_chars(sv.data(), sv.data() + sv.size(), v);
+            return v;
+        });
+        std::printf("%-12s %9.2f ns %9.2f ns %9.2f ns %9.2f ns\n", kind, fast, ref, fast_f, ref_f);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+//
+// Created by lehoai on 2/24/26.
+//
+
+#ifndef SIMDCSV_CHECKPOINT_H
+#define SIMDCSV_CHECKPOINT_H
+
+// resume point of an interrupted parse, see CsvReader::parse_from
+// taken at a row start, which is always outside quotes: the offset alone restarts the parser,
+// no quote or field state is stored
+// valid only for the same file (inode, size, mtime) read with the same format
+//
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+
+#include "row_index.h"
+
+namespace csv {
+
+    struct checkpoint {
+        uint64_t offset = 0;    // file offset of the next row to parse
+        uint64_t row = 0;       // data rows before offset, filtered ones included
+        index_stamp stamp;      // size, mtime and format of the file
+        uint64_t inode = 0;
+
+        // fixed size binary blob in host byte order, like the row index sidecar
+        [[nodiscard]] inline std::string serialize() const;
+        // throws std::invalid_argument on a blob that is not a checkpoint
+        static inline checkpoint deserialize(std::string_view bytes);
+    };
+
+    inline uint64_t inode_of(const char* path) {
+        struct stat st{};
+        if (stat(path, &st) == -1) {
+            throw std::runtime_error("Cannot stat file");
+        }
+        return static_cast<uint64_t>(st.st_ino);
+    }
+
+    namespace detail {
+        constexpr char CHECKPOINT_MAGIC[8] = {'S', 'C', 'S', 'V', 'C', 'K', 'P', '1'};
+    }
+}
+
+std::string csv::checkpoint::serialize() const {
+    std::string buf(detail::CHECKPOINT_MAGIC, sizeof(detail::CHECKPOINT_MAGIC));
+    detail::put_raw(buf, offset);
+    detail::put_raw(buf, row);
+    detail::put_raw(buf, inode);
+    detail::put_raw(buf, stamp.size);
+    detail::put_raw(buf, stamp.mtime_ns);
+    detail::put_raw(buf, stamp.new_line);
+    detail::put_raw(buf, stamp.line_ending);
+    detail::put_raw(buf, stamp.quote);
+    detail::put_raw(buf, static_cast<char>(stamp.has_quote));
+    detail::put_raw(buf, stamp.header_row);
+    return buf;
+}
+
+csv::checkpoint csv::checkpoint::deserialize(const std::string_view bytes) {
+    const char* p = bytes.data();
+    const char* end = p + bytes.size();
+    if (bytes.size() < sizeof(detail::CHECKPOINT_MAGIC)
+        || std::memcmp(p, detail::CHECKPOINT_MAGIC, sizeof(detail::CHECKPOINT_MAGIC)) != 0) {
+        throw std::invalid_argument("Not a checkpoint");
+    }
+    p += sizeof(detail::CHECKPOINT_MAGIC);
+
+    checkpoint out;
+    char has_quote = 0;
+    if (!detail::get_raw(p, end, out.offset) || !detail::get_raw(p, end, out.row)
+        || !detail::get_raw(p, end, out.inode) || !detail::get_raw(p, end, out.stamp.size)
+        || !detail::get_raw(p, end, out.stamp.mtime_ns) || !detail::get_raw(p, end, out.stamp.new_line)
+        || !detail::get_raw(p, end, out.stamp.line_ending) || !detail::get_raw(p, end, out.stamp.quote)
+        || !detail::get_raw(p, end, has_quote) || !detail::get_raw(p, end, out.stamp.header_row)
+        || p != end || out.offset > out.stamp.size) {
+        throw std::invalid_argument("Not a checkpoint");
+    }
+    out.stamp.has_quote = has_quote != 0;
+    return out;
+}
+
+#endif //SIMDCSV_CHECKPOINT_H
@@ -0,0 +1,343 @@
+//
+// Created by lehoai on 2/10/26.
+//
+
+#ifndef SIMDCSV_COLUMNAR_H
+#define SIMDCSV_COLUMNAR_H
+
+// column-major batches
+// every column is an Arrow binary view array: 16-byte views, strings <= 12 bytes are inlined,
+// longer strings point into the reader's input (mapping or stream buffer), nothing is copied;
+// unescaped strings point into the sink's arena. a data buffer never mixes sources: the input
+// and every arena chunk get buffers of their own
+// export_arrow() copies the buffers that don't outlive the callback (arena chunks, a stream's
+// buffer) into the exported arrays, mapping buffers are handed over as they are
+// export_arrow() hands a batch to any Arrow C Data Interface consumer
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "unescape.h"
+
+// Arrow C Data Interface, ABI from arrow/c/abi.h
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace csv {
+
+    // Arrow binary view: size <= 12 -> bytes inline after size, else prefix + (buffer, offset)
+    struct arrow_view {
+        int32_t size;
+        char prefix[4];
+        int32_t buffer_index;
+        int32_t offset;
+    };
+    static_assert(sizeof(arrow_view) == 16, "arrow view must be 16 bytes");
+
+    class ColumnBatch {
+    private:
+        std::vector<std::string> _names;
+        std::vector<std::vector<arrow_view>> _columns;
+        std::vector<const char*> _data;   // variadic data buffers
+        std::vector<int64_t> _data_size;
+        std::vector<const char*> _data_source;   // by buffer: arena chunk, nullptr for the input
+        size_t _rows = 0;
+        size_t _capacity = 0;
+        bool _input_stable = true;   // the input outlives the batch (a mapping)
+
+        inline int32_t buffer_for(std::string_view value, const char* source);
+    public:
+        // input_stable: the input outlives the batch, false for a stream buffer refilled after the callback
+        ColumnBatch(std::vector<std::string> names, size_t capacity, bool input_stable = true);
+
+        [[nodiscard]] size_t rows() const { return _rows; }
+        [[nodiscard]] size_t columns() const { return _columns.size(); }
+        [[nodiscard]] const std::string& name(size_t column) const { return _names[column]; }
+        [[nodiscard]] const arrow_view* views(size_t column) const { return _columns[column].data(); }
+        [[nodiscard]] inline std::string_view value(size_t column, size_t row) const;
+
+        // batch building, used by the reader
+        // source: the arena chunk holding value, nullptr when value is in the input
+        inline void append(size_t column, std::string_view value, const char* source = nullptr);
+        inline void end_row();
+        // discard the fields appended since the last end_row()
+        inline void drop_row();
+        inline void clear();
+
+        // move the batch into Arrow structs (struct of utf8_view columns), the batch is empty afterwards
+        // long values of a mapped file still point into the mapping, keep the reader alive while the
+        // arrays live; stream and unescaped values are copied into the arrays
+        // schema may be nullptr
+        inline void export_arrow(ArrowArray* out, ArrowSchema* schema);
+    };
+
+    namespace detail {
+        // memory behind one exported batch, shared by the parent and child arrays
+        struct arrow_batch {
+            std::vector<std::vector<arrow_view>> views;
+            std::vector<const char*> data;
+            std::vector<int64_t> data_size;
+            std::vector<std::unique_ptr<char[]>> owned;   // copied data buffers
+            std::vector<std::vector<const void*>> buffers;
+            std::vector<ArrowArray> children;
+            std::vector<ArrowArray*> child_ptrs;
+        };
+
+        struct arrow_schema {
+            std::vector<std::string> names;
+            std::vector<ArrowSchema> children;
+            std::vector<ArrowSchema*> child_ptrs;
+        };
+
+        inline void release_child_array(ArrowArray* array) {
+            delete static_cast<std::shared_ptr<arrow_batch>*>(array->private_data);
+            array->release = nullptr;
+        }
+
+        inline void release_batch_array(ArrowArray* array) {
+            auto* state = static_cast<std::shared_ptr<arrow_batch>*>(array->private_data);
+            for (ArrowArray* child : (*state)->child_ptrs) {
+                if (child->release) child->release(child);
+            }
+            delete state;
+            array->release = nullptr;
+        }
+
+        inline void release_child_schema(ArrowSchema* schema) {
+            delete static_cast<std::shared_ptr<arrow_schema>*>(schema->private_data);
+            schema->release = nullptr;
+        }
+
+        inline void release_batch_schema(ArrowSchema* schema) {
+            auto* state = static_cast<std::shared_ptr<arrow_schema>*>(schema->private_data);
+            for (ArrowSchema* child : (*state)->child_ptrs) {
+                if (child->release) child->release(child);
+            }
+            delete state;
+            schema->release = nullptr;
+        }
+
+        // fills a ColumnBatch and hands it to the callback every batch_rows rows
+        template <typename BatchCallback>
+        struct column_sink {
+            ColumnBatch batch;
+            size_t batch_rows;
+            const BatchCallback& callback;
+            detail::arena scratch;
+
+            column_sink(const std::vector<std::string>& names, const size_t batch_rows, const BatchCallback& callback,
+                        const bool input_stable)
+                : batch(names, batch_rows, input_stable), batch_rows(batch_rows), callback(callback) {}
+
+            void field(const int slot, const std::string_view value) {
+                // only long values live in a data buffer
+                batch.append(slot, value, value.size() > 12 ? scratch.chunk_of(value.data()) : nullptr);
+            }
+
+            void drop() {
+                batch.drop_row();
+            }
+
+            void row(const int) {
+                batch.end_row();
+                if (batch.rows() == batch_rows) {
+                    emit();
+                }
+            }
+
+            void flush() {
+                if (batch.rows() > 0) {
+                    emit();
+                }
+            }
+
+            void emit() {
+                callback(batch);
+                batch.clear();
+                scratch.reset();
+            }
+
+            detail::arena& arena() { return scratch; }
+        };
+    }
+}
+
+inline csv::ColumnBatch::ColumnBatch(std::vector<std::string> names, const size_t capacity, const bool input_stable) {
+    _names = std::move(names);
+    _capacity = capacity;
+    _input_stable = input_stable;
+    _columns.resize(_names.size());
+    clear();
+}
+
+std::string_view csv::ColumnBatch::value(const size_t column, const size_t row) const {
+    const arrow_view& view = _columns[column][row];
+    if (view.size <= 12) {
+        return {reinterpret_cast<const char*>(&view) + 4, static_cast<size_t>(view.size)};
+    }
+    return {_data[view.buffer_index] + view.offset, static_cast<size_t>(view.size)};
+}
+
+int32_t csv::ColumnBatch::buffer_for(const std::string_view value, const char* source) {
+    // the latest buffer of the same source; values of one source arrive in address order
+    auto idx = static_cast<int32_t>(_data.size()) - 1;
+    while (idx >= 0 && _data_source[idx] != source) idx--;
+    // int32 offsets: open a new data buffer once that one would pass 2GB
+    if (idx < 0 || value.data() < _data[idx]
+        || value.data() + value.size() - _data[idx] > INT32_MAX) {
+        _data.push_back(value.data());
+        _data_size.push_back(0);
+        _data_source.push_back(source);
+        idx = static_cast<int32_t>(_data.size()) - 1;
+    }
+    _data_size[idx] = std::max<int64_t>(_data_size[idx], value.data() + value.size() - _data[idx]);
+    return idx;
+}
+
+void csv::ColumnBatch::append(const size_t column, const std::string_view value, const char* source) {
+    arrow_view view{};
+    view.size = static_cast<int32_t>(value.size());
+    if (value.size() <= 12) {
+        std::memcpy(reinterpret_cast<char*>(&view) + 4, value.data(), value.size());
+    } else {
+        std::memcpy(view.prefix, value.data(), 4);
+        view.buffer_index = buffer_for(value, source);
+        view.offset = static_cast<int32_t>(value.data() - _data[view.buffer_index]);
+    }
+    _columns[column].push_back(view);
+}
+
+void csv::ColumnBatch::end_row() {
+    _rows++;
+}
+
+void csv::ColumnBatch::drop_row() {
+    for (auto& column : _columns) {
+        column.resize(std::min(column.size(), _rows));
+    }
+}
+
+void csv::ColumnBatch::clear() {
+    for (auto& column : _columns) {
+        column.clear();
+        column.reserve(_capacity);
+    }
+    _data.clear();
+    _data_size.clear();
+    _data_source.clear();
+    _rows = 0;
+}
+
+void csv::ColumnBatch::export_arrow(ArrowArray *out, ArrowSchema *schema) {
+    const size_t n = _columns.size();
+
+    auto state = std::make_shared<detail::arrow_batch>();
+    state->views = std::move(_columns);
+    state->data = std::move(_data);
+    state->data_size = std::move(_data_size);
+    // arena chunks are reset and a stream buffer refilled once the callback returns
+    for (size_t i = 0; i < state->data.size(); i++) {
+        if (_data_source[i] == nullptr && _input_stable) continue;
+        const auto size = static_cast<size_t>(state->data_size[i]);
+        state->owned.push_back(std::make_unique<char[]>(size));
+        std::memcpy(state->owned.back().get(), state->data[i], size);
+        state->data[i] = state->owned.back().get();
+    }
+    state->buffers.resize(n);
+    state->children.resize(n);
+    state->child_ptrs.resize(n);
+
+    // child buffers: validity (none), views, variadic data buffers..., variadic buffer sizes
+    for (size_t c = 0; c < n; c++) {
+        auto& buffers = state->buffers[c];
+        buffers.push_back(nullptr);
+        buffers.push_back(state->views[c].data());
+        buffers.insert(buffers.end(), state->data.begin(), state->data.end());
+        buffers.push_back(state->data_size.data());
+
+        ArrowArray& child = state->children[c];
+        child = ArrowArray{};
+        child.length = static_cast<int64_t>(_rows);
+        child.n_buffers = static_cast<int64_t>(buffers.size());
+        child.buffers = buffers.data();
+        child.release = detail::release_child_array;
+        child.private_data = new std::shared_ptr<detail::arrow_batch>(state);
+        state->child_ptrs[c] = &child;
+    }
+
+    static const void* struct_buffers[1] = {nullptr};
+    *out = ArrowArray{};
+    out->length = static_cast<int64_t>(_rows);
+    out->n_buffers = 1;
+    out->buffers = struct_buffers;
+    out->n_children = static_cast<int64_t>(n);
+    out->children = state->child_ptrs.data();
+    out->release = detail::release_batch_array;
+    out->private_data = new std::shared_ptr<detail::arrow_batch>(state);
+
+    if (schema != nullptr) {
+        auto names = std::make_shared<detail::arrow_schema>();
+        names->names = _names;
+        names->children.resize(n);
+        names->child_ptrs.resize(n);
+        for (size_t c = 0; c < n; c++) {
+            ArrowSchema& child = names->children[c];
+            child = ArrowSchema{};
+            child.format = "vu";
+            child.name = names->names[c].c_str();
+            child.release = detail::release_child_schema;
+            child.private_data = new std::shared_ptr<detail::arrow_schema>(names);
+            names->child_ptrs[c] = &child;
+        }
+        *schema = ArrowSchema{};
+        schema->format = "+s";
+        schema->name = "";
+        schema->n_children = static_cast<int64_t>(n);
+        schema->children = names->child_ptrs.data();
+        schema->release = detail::release_batch_schema;
+        schema->private_data = new std::shared_ptr<detail::arrow_schema>(names);
+    }
+
+    // batch starts over with fresh buffers
+    _columns.clear();
+    _columns.resize(n);
+    clear();
+}
+
+#endif //SIMDCSV_COLUMNAR_H
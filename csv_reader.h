@@ -6,25 +6,95 @@
 #define SIMDCSV_CSV_READER_H
 
 #include <string_view>
-#include <immintrin.h>
+#include <cstring>
 #include <vector>
 #include <thread>
 #include <charconv>
 #include <optional>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <exception>
+#include <cmath>
+#include <limits>
 
 #include "mmap.h"
+#include "stream.h"
+#include "read.h"
+#include "watch.h"
+#include "simd.h"
+#include "columnar.h"
+#include "decode.h"
+#include "number.h"
+#include "filter.h"
+#include "row_index.h"
+#include "checkpoint.h"
+#include "dictionary.h"
+#include "aggregate.h"
+#include "row_block.h"
+#include "unescape.h"
+#include "infer.h"
+#include "stats.h"
+#include "progress.h"
 
 constexpr size_t BUFFER_SIZE = 128 * 1024;
-constexpr size_t PREFETCH_CHUNK = 64 * 1024 * 1024;  // 64MB prefetch ahead
+constexpr size_t STREAM_BLOCKS = 8;  // stream buffer = 8 x BUFFER_SIZE
+constexpr size_t PREFETCH_CHUNK = 64 * 1024 * 1024;  // 64MB, largest parallel chunk
 constexpr size_t PAGE_SIZE = 4096;
+constexpr size_t INDEX_STRIDE = 1024;  // rows per row index sample
+constexpr size_t INFER_CHECK_ROWS = 8;  // rows split to confirm a guessed quote state at a seek point
 namespace csv {
+    // row terminators
+    enum class eol {
+        single,  // format.new_line only
+        crlf,    // "\r\n" or '\n', a lone '\r' is data
+        any,     // "\r\n", '\n' or a lone '\r'
+    };
+
     struct format {
         char delimiter = ',';
         char new_line = '\n';
+        // crlf / any: new_line is ignored, the '\r' of "\r\n" never reaches a field
+        csv::eol line_ending = csv::eol::single;
         std::optional<char> quote;
         int header_row =0;
+        // RFC 4180: turn doubled quotes inside quoted fields back into one quote
+        // escaped fields are copied to a scratch arena and only valid until the callback returns
+        bool unescape = false;
+    };
+
+    // options for CsvReader::parse_parallel
+    struct parallel_options {
+        unsigned threads = 0;     // 0 = std::thread::hardware_concurrency()
+        bool ordered = false;     // deliver rows in file order (buffers one chunk per worker)
+        size_t chunk_size = 0;    // bytes per chunk, 0 = auto
+    };
+
+    // options for CsvReader::follow
+    struct follow_options {
+        uint64_t offset = 0;                           // resume at follow_state::offset, 0 = first data row
+        std::chrono::milliseconds poll{100};           // longest wait between size checks
+        std::chrono::milliseconds idle{0};             // return after this long without growth, 0 = never
+        const std::atomic<bool>* stop = nullptr;       // return once set, checked between waits
+    };
+
+    // where CsvReader::follow stopped
+    struct follow_state {
+        uint64_t offset = 0;   // start of the first row not delivered, pass it back to resume
+        uint64_t rows = 0;     // rows delivered by this call
+    };
+
+    // result of CsvReader::count_rows
+    struct row_stats {
+        uint64_t rows = 0;    // data rows after the header, as parse() would deliver them (filters ignored)
+        uint64_t lines = 0;   // physical lines, newlines inside quoted fields included
+        uint64_t bytes = 0;   // bytes after the header
     };
 
     // Prefix XOR
@@ -49,68 +119,799 @@ namespace csv {
         return sv;
     }
 
-    // helper convert string_view to data
-    // std::from_chars for best performance
+    namespace detail {
+        // the row terminator ends at p; a '\r' with no byte after it in [p, stop) is not decided yet
+        inline bool row_ends_at(const csv::format& format, const char* p, const char* stop) {
+            switch (format.line_ending) {
+                case csv::eol::crlf: return *p == '\n';
+                case csv::eol::any: return *p == '\n' || (*p == '\r' && p + 1 < stop && p[1] != '\n');
+                default: return *p == format.new_line;
+            }
+        }
+
+        // byte by byte split of the row starting at p, on_field(trimmed field) for each field
+        // returns the next row start, nullptr when the row is not terminated before end
+        // header rows and samples only, the parse loop uses the kernel masks
+        template <typename OnField>
+        const char* split_row(const char* p, const char* end, const csv::format& format, const OnField& on_field) {
+            const char* field_start = p;
+            bool in_quote = false;
+            for (; p < end; p++) {
+                const char c = *p;
+                if (format.quote.has_value() && c == format.quote.value()) {
+                    in_quote = !in_quote;
+                } else if (!in_quote) {
+                    const bool row_end = row_ends_at(format, p, end);
+                    if (c == format.delimiter || row_end) {
+                        // drop the '\r' of "\r\n"
+                        const bool cr = row_end && format.line_ending != csv::eol::single && *p == '\n'
+                                        && p > field_start && p[-1] == '\r';
+                        on_field(trim_quotes(std::string_view(field_start, p - cr - field_start), format));
+                        field_start = p + 1;
+                        if (row_end) {
+                            return p + 1;
+                        }
+                    }
+                }
+            }
+            if (field_start < end) {
+                const bool cr = format.line_ending != csv::eol::single && end[-1] == '\r';
+                on_field(trim_quotes(std::string_view(field_start, end - cr - field_start), format));
+            }
+            return nullptr;
+        }
+    }
+
+    // helper convert string_view to data, reports why a field did not convert
+    // float/double use the fast path in number.h, everything else std::from_chars
+    template<typename T>
+    inline parse_status try_get(std::string_view sv, T& value) {
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            return parse_float(sv, value);
+        } else {
+            if (sv.empty()) {
+                return parse_status::empty;
+            }
+            const auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
+            if (ec == std::errc::result_out_of_range) return parse_status::out_of_range;
+            if (ec != std::errc() || ptr != sv.data() + sv.size()) return parse_status::invalid;
+            return parse_status::ok;
+        }
+    }
+
+    // T{} when the field does not convert, use try_get to tell the cases apart
     template<typename T>
     inline T get(std::string_view sv) {
         T value{};
-        std::from_chars(sv.data(), sv.data() + sv.size(), value);
+        if (try_get(sv, value) != parse_status::ok) {
+            return T{};
+        }
         return value;
     }
 
 
+    namespace detail {
+        // parse_rows() output policy:
+        //   field(slot, value) slot = position in the selected columns, missing fields arrive empty
+        //   row(fields)        end of row, fields = number of fields seen
+        //   drop()             a filter rejected the row, forget its fields
+        //   flush()            views into the current buffer are about to expire
+        //   arena()            where unescaped fields are copied (format.unescape)
+        // KeepFields: the caller resets the arena itself, rows outlive the callback
+        template <typename RowCallback, bool KeepFields = false>
+        struct row_sink {
+            std::string_view* current_row;
+            const RowCallback& callback;
+            detail::arena scratch{};
+
+            void field(const int slot, const std::string_view value) {
+                current_row[slot] = value;
+            }
+
+            void drop() {
+                if constexpr (!KeepFields) scratch.reset();
+            }
+
+            void row(const int) {
+                callback(current_row);
+                if constexpr (!KeepFields) scratch.reset();
+            }
+
+            void flush() {}
+
+            detail::arena& arena() { return scratch; }
+        };
+
+        // run work(worker) on `threads` threads, worker 0 is the calling thread
+        // the first exception of any worker sets *stop (work polls it to quit early), every
+        // thread is joined and the exception is rethrown on the calling thread
+        template <typename Work>
+        void run_workers(const unsigned threads, const Work& work, std::atomic<bool>* stop = nullptr) {
+            std::exception_ptr error;
+            std::mutex error_mtx;
+            auto guarded = [&](const unsigned worker) {
+                try {
+                    work(worker);
+                } catch (...) {
+                    if (stop) stop->store(true, std::memory_order_relaxed);
+                    std::lock_guard<std::mutex> lock(error_mtx);
+                    if (!error) error = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            try {
+                for (unsigned w = 1; w < threads; w++) {
+                    pool.emplace_back(guarded, w);
+                }
+            } catch (...) {
+                // no thread left to start: stop the ones running and report
+                if (stop) stop->store(true, std::memory_order_relaxed);
+                for (auto& t : pool) t.join();
+                throw;
+            }
+            guarded(0u);
+            for (auto& t : pool) t.join();
+            if (error) std::rethrow_exception(error);
+        }
+
+        // sinks with row_start(ptr) are told where every row after a newline begins
+        template <typename T, typename = void>
+        struct has_row_start : std::false_type {};
+        template <typename T>
+        struct has_row_start<T, std::void_t<decltype(&T::row_start)>> : std::true_type {};
+
+        // samples every stride-th row start while forwarding to the real sink
+        template <typename Sink>
+        struct index_sink {
+            Sink& inner;
+            RowIndex& index;
+            const char* base;
+            uint64_t rows = 0;
+
+            void field(const int slot, const std::string_view value) { inner.field(slot, value); }
+            void row(const int fields) { inner.row(fields); rows++; }
+            void drop() { inner.drop(); rows++; }
+            void flush() { inner.flush(); }
+            detail::arena& arena() { return inner.arena(); }
+
+            void row_start(const char* ptr) {
+                if (rows % index.stride() == 0) index.add(ptr - base);
+            }
+        };
+
+        // counts rows and hands on_checkpoint a checkpoint at the row start after a requested one
+        template <typename Sink, typename OnCheckpoint>
+        struct checkpoint_sink {
+            Sink& inner;
+            const OnCheckpoint& on_checkpoint;
+            bool& requested;      // set by the row callback
+            const char* base;
+            csv::checkpoint next;
+
+            void field(const int slot, const std::string_view value) { inner.field(slot, value); }
+            void row(const int fields) { inner.row(fields); next.row++; }
+            void drop() { inner.drop(); next.row++; }
+            void flush() { inner.flush(); }
+            detail::arena& arena() { return inner.arena(); }
+
+            void row_start(const char* ptr) {
+                if (!requested) return;
+                requested = false;
+                next.offset = ptr - base;
+                on_checkpoint(static_cast<const csv::checkpoint&>(next));
+            }
+        };
+
+        // delivers count rows after skipping skip rows, counts rejected rows too
+        template <typename Sink>
+        struct range_sink {
+            Sink& inner;
+            uint64_t skip;
+            uint64_t count;
+
+            void field(const int slot, const std::string_view value) { inner.field(slot, value); }
+            void row(const int fields) {
+                if (skip > 0) skip--;
+                else if (count > 0) { count--; inner.row(fields); }
+            }
+            void drop() {
+                if (skip > 0) skip--;
+                else if (count > 0) count--;
+            }
+            void flush() { inner.flush(); }
+            detail::arena& arena() { return inner.arena(); }
+        };
+    }
+
+    class Dataset;
+
     class CsvReader {
     private:
+        // schedules chunks of many readers on one pool, see dataset.h
+        friend class csv::Dataset;
+
         const char* file_path = nullptr;
         csv::format format;
         std::unique_ptr<csv::file::FMmap> f_map;
+        std::unique_ptr<csv::file::FSource> f_stream;   // fd stream, or a file read with pread
+        csv::io_mode io = csv::io_mode::mmap;
+        csv::prefetch_mode prefetch = csv::prefetch_mode::touch;
+        size_t prefetch_distance = 0;
+        bool stream_consumed = false;
+        bool header_pending = false;   // mapped file whose header row is not terminated yet (follow)
         const char* end = nullptr;
         int col_num = 0;
+        // projection: slots[col] = position in the callback row or -1, fields from skip_from on are never read
+        std::vector<int> slots;
+        int out_cols = 0;
+        int skip_from = 0;
+        // filters: filter_at[col] = first filter on col or -1, no filtered column from filter_from on
+        std::vector<detail::row_filter> filters;
+        std::vector<int> filter_at;
+        int filter_from = 0;
+        // row index, built by the next serial parse when index_stride is set and none is loaded
+        std::unique_ptr<csv::RowIndex> row_index;
+        size_t index_stride = 0;
         const char* data_start = nullptr;
         std::vector<std::string> headers;
-        inline void parse_header_row(const char* data);
+        // SIMDCSV_STATS only, nullptr otherwise
+        std::unique_ptr<detail::stats_state> stats_state;
+        // dictionaries of the last parse_encoded, by column name
+        std::vector<std::string> encoded_names;
+        std::vector<csv::Dictionary> dictionaries;
+        // escaped fields of mapped parse_blocks rows, kept until the next parse_blocks
+        detail::arena block_bytes;
+        // return false if the header row is not terminated by a newline before end
+        inline bool parse_header_row(const char* data);
+        // fill f_stream until the header row is complete
+        inline void read_stream_header();
+
+        // scan rows in [begin, stop), begin must be a row start (outside quote)
+        // last = false: stop early at the unfinished row and return its start
+        // progress(pos) is called about every 64KB with the scan position
+        template <typename Sink, typename Progress>
+        const char* parse_rows(const char* begin, const char* stop, bool last, Sink& out,
+                               const Progress& progress) const;
+
+        // parse_rows() body, the filter checks and quote counting compile away when unused
+        template <bool Filtered, bool Unescape, typename Sink, typename Progress>
+        const char* scan_rows(const char* begin, const char* stop, bool last, Sink& out,
+                              const Progress& progress) const;
+
+        // drive parse_rows over the whole input (mapped file or stream)
+        // begin: row start of a mapped file to parse from, nullptr = first data row
+        template <typename Sink>
+        void run(Sink& out, const char* begin = nullptr);
+
+        template <typename Sink>
+        void run_stream(Sink& out);
+
+        // trimmed field, unescaped into out.arena() when it holds more than its outer quotes
+        template <bool Unescape, typename Sink>
+        std::string_view field_value(std::string_view raw, uint64_t quotes, Sink& out) const;
+
+        // pad missing selected fields and close the row, or drop it if a filter failed
+        // missing filtered fields are tested as empty
+        template <typename Sink>
+        void end_row(Sink& out, int fields, bool dropped) const;
+
+        // every filter on col accepts value
+        inline bool accept(int col, std::string_view value) const;
+
+        // SIMDCSV_STATS: rows and fields of one block from its masks, row_fields carries the open row
+        inline void tally_block(const csv::simd::block_masks& masks, int& row_fields, csv::parse_stats& s) const;
+        inline void tally_row(int fields, csv::parse_stats& s) const;
+        // add one scan_rows() call's counters, ticks converted to ns
+        inline void add_stats(csv::parse_stats& s, const detail::tick_clock& clock,
+                              uint64_t kernel_ticks, uint64_t callback_ticks) const;
+
+        // drop separators up to the next newline; clears skipping once it is found
+        static inline uint64_t skip_to_newline(uint64_t sep_mask, uint64_t newline_mask, bool& skipping);
+
+        inline csv::simd::pattern simd_pattern() const;
+
+        // newline counts of [begin, stop) starting outside quotes, returns the quote state at stop
+        inline uint64_t count_range(const char* begin, const char* stop, csv::simd::newline_count& out) const;
+        // rows/lines for a last row without newline
+        inline void finish_count(csv::row_stats& stats, char last, uint64_t in_quote) const;
+        inline csv::row_stats count_stream();
+
+        // calls on_row(ptr) after every newline in [begin, stop), begin must be a row start
+        template <typename OnRow>
+        void scan_row_ends(const char* begin, const char* stop, const OnRow& on_row) const;
+
+        inline std::string index_path() const;
+        inline csv::index_stamp current_stamp() const;
+        // the sidecar is a cache: a failed write keeps the in-memory index and returns false
+        inline bool save_index() const;
+
+        // quote count parity of [begin, stop)
+        inline uint32_t quote_parity(const char* begin, const char* stop) const;
+
+        // first row start at or after pos, given the quote state at pos
+        // limit: stop looking there and return it, nullptr = end
+        inline const char* next_row_start(const char* pos, uint32_t in_quote, const char* limit = nullptr) const;
+
+        // row start after pos when the quote state at pos is unknown: both guesses are tried and
+        // the one whose next rows split into col_num fields wins
+        // only [pos, pos + window) is looked at, end when it holds no row start
+        inline const char* sample_start(const char* pos, size_t window) const;
+        // leading rows from row that split into col_num fields before limit, at most INFER_CHECK_ROWS
+        inline size_t consistent_rows(const char* row, const char* limit) const;
+
+        // follow: remap after growth and move data_start / end with the mapping
+        inline bool grow_mapping();
+
+        // restores the caller's column selection on every exit
+        struct ProjectionGuard {
+            CsvReader& reader;
+            std::vector<int> slots;
+            int out_cols;
+            int skip_from;
+            ~ProjectionGuard() {
+                reader.slots = std::move(slots);
+                reader.out_cols = out_cols;
+                reader.skip_from = skip_from;
+            }
+        };
     public:
-        CsvReader(const char* file_path, csv::format format);
+        // io.mode picks mmap advice or pread; pread / direct read the file like a stream:
+        // one serial pass, no parse_parallel, parse_range or infer
+        CsvReader(const char* file_path, csv::format format, csv::io_policy io = {});
+        // streaming input (pipe, socket, stdin), fd stays owned by the caller
+        // parse() consumes the stream, so it can run only once
+        CsvReader(int fd, csv::format format);
         template <typename RowCallback>
         void parse(const RowCallback &callback);
 
+        // tail a growing file: parse to the end, wait for appends (inotify, else polling), remap, go on
+        // only complete rows are delivered, a row cut by the current end of file is parsed again
+        // once its newline arrives, so a row split across two appends arrives once
+        // a file still without a complete header row is waited on, its projection and filters are reset
+        template <typename RowCallback>
+        csv::follow_state follow(const RowCallback &callback, follow_options options = {});
+
+        // split [data_start, end) into chunks parsed by a thread pool
+        // callback(worker, row) is called concurrently from all workers unless options.ordered
+        template <typename RowCallback>
+        void parse_parallel(const RowCallback &callback, parallel_options options = {});
+
+        // rows, lines and bytes without splitting fields: the kernel only tracks quotes and
+        // counts newlines. a stream is consumed like parse()
+        inline csv::row_stats count_rows();
+        // same counts, chunks are counted concurrently in one pass over the mapping
+        inline csv::row_stats count_rows_parallel(parallel_options options = {}) const;
+
+        // row-major blocks of up to block_rows rows, callback(const csv::RowBlock&) runs once per block
+        // fields of a mapped file stay valid for the reader's lifetime, escaped fields (format.unescape)
+        // until the next parse_blocks, stream fields only until the callback returns
+        template <typename BlockCallback>
+        void parse_blocks(size_t block_rows, const BlockCallback &callback);
+
+        // column-major batches of up to batch_rows rows, callback(csv::ColumnBatch&)
+        // fields are views into the mapping (or stream buffer), valid until the callback returns;
+        // export_arrow() arrays of a mapped file live as long as the reader, see columnar.h
+        template <typename BatchCallback>
+        void parse_columns(size_t batch_rows, const BatchCallback &callback);
+
+        // read only the schema's columns and decode them, callback(const csv::TypedBatch&)
+        // the column selection is restored afterwards
+        template <typename BatchCallback>
+        void parse_typed(const csv::schema& schema, size_t batch_rows, const BatchCallback &callback);
+
+        // type, null rate and approximate cardinality of every column from rows sampled at
+        // options.samples row boundaries spread over the file, options.sample_bytes each;
+        // small files are read whole. filters apply, the column selection does not
+        inline csv::profile infer(infer_options options = {});
+
         std::vector<std::string> getHeaders() {
             return headers;
         }
+
+        // projection pushdown: callbacks receive only these columns, in this order
+        // unselected fields are neither trimmed nor stored; an empty list selects every column
+        inline void select_columns(const std::vector<int>& columns);
+        inline void select_columns(const std::vector<std::string>& names);
+        // headers of the selected columns
+        inline std::vector<std::string> selected_headers() const;
+
+        // row index sidecar (<file>.idx): load it if it matches the file, size, mtime and format,
+        // otherwise the next serial parse builds and saves it
+        inline void use_index(size_t stride = INDEX_STRIDE);
+        // scan only the newlines, build the index and save it
+        inline void build_index(size_t stride = INDEX_STRIDE);
+        // nullptr until loaded or built
+        [[nodiscard]] const csv::RowIndex* index() const { return row_index.get(); }
+
+        // rows [first_row, first_row + count), row 0 is the first row after the header
+        // jumps to the nearest index sample, the index is loaded or built when missing
+        template <typename RowCallback>
+        void parse_range(size_t first_row, size_t count, const RowCallback &callback);
+
+        // checkpoint at the first data row, where a fresh parse_from starts
+        inline csv::checkpoint begin_checkpoint() const;
+        // parse the rows from a checkpoint taken on this file, straight from its offset
+        // callback(row) may return true to request a checkpoint right after that row, which is
+        // handed to on_checkpoint(const csv::checkpoint&) before the next row is delivered
+        // a checkpoint of another file, size, mtime or format throws std::invalid_argument
+        template <typename RowCallback, typename CheckpointCallback>
+        void parse_from(const csv::checkpoint& from, const RowCallback &callback,
+                        const CheckpointCallback &on_checkpoint);
+        template <typename RowCallback>
+        void parse_from(const csv::checkpoint& from, const RowCallback &callback);
+
+        // dictionary encoding of low-cardinality columns: callback(row, codes) where codes[i] is the
+        // dense code of the i-th named column's field, first seen value = 0. names must be selected
+        // only delivered rows are encoded, the dictionaries start empty on every call
+        template <typename RowCallback>
+        void parse_encoded(const std::vector<std::string>& names, const RowCallback &callback);
+        // dictionary of a column of the last parse_encoded, nullptr if it was not encoded
+        [[nodiscard]] inline const csv::Dictionary* dictionary(const std::string& name) const;
+
+        // GROUP BY query.key with query.aggregates, on parse_parallel's workers for a mapped file
+        // (serial for a stream). filters apply, the column selection is restored afterwards
+        inline csv::group_table group_by(const csv::group_query& query, parallel_options options = {});
+
+        // predicate pushdown: only rows accepted by every filter reach the callbacks
+        // filtered columns do not need to be selected
+        inline void add_filter(const csv::predicate& predicate);
+        inline void clear_filters();
+
+        // counters of every parse so far, all zero unless built with SIMDCSV_STATS (see stats.h)
+        [[nodiscard]] inline csv::parse_stats stats() const;
+        inline void reset_stats();
     };
 }
 
-inline csv::CsvReader::CsvReader(const char *file_path, const csv::format format) {
+inline csv::CsvReader::CsvReader(const char *file_path, const csv::format format, const csv::io_policy io) {
     this->file_path = file_path;
     this->format = format;
+    this->io = io.mode;
+    this->prefetch = io.prefetch;
+    this->prefetch_distance = std::max(io.prefetch_distance, PAGE_SIZE);
 
-    f_map = std::make_unique<csv::file::FMmap>(file_path);
+    if (io.mode == csv::io_mode::pread || io.mode == csv::io_mode::direct) {
+        f_stream = std::make_unique<csv::file::FRead>(file_path, io);
+        read_stream_header();
+        select_columns(std::vector<int>{});
+        clear_filters();
+        if constexpr (STATS_ENABLED) stats_state = std::make_unique<detail::stats_state>();
+        return;
+    }
+    f_map = std::make_unique<csv::file::FMmap>(file_path, io.mode);
 
     const char *data = f_map->data();
     const size_t size = f_map->size();
     this->end = data + size;
 
     // Auto-detect header and column count
-    parse_header_row(data);
+    header_pending = !parse_header_row(data);
+    select_columns(std::vector<int>{});
+    clear_filters();
+    if constexpr (STATS_ENABLED) stats_state = std::make_unique<detail::stats_state>();
+}
+
+inline csv::CsvReader::CsvReader(const int fd, const csv::format format) {
+    this->format = format;
+
+    f_stream = std::make_unique<csv::file::FStream>(fd, BUFFER_SIZE, STREAM_BLOCKS);
+    read_stream_header();
+    select_columns(std::vector<int>{});
+    clear_filters();
+    if constexpr (STATS_ENABLED) stats_state = std::make_unique<detail::stats_state>();
+}
+
+void csv::CsvReader::read_stream_header() {
+    while (true) {
+        f_stream->fill(f_stream->data());
+        this->end = f_stream->data() + f_stream->size();
+        headers.clear();
+        if (parse_header_row(f_stream->data()) || f_stream->eof()) {
+            break;
+        }
+    }
 }
 
 template <typename RowCallback>
 void csv::CsvReader::parse(const RowCallback &callback) {
-    const char* ptr = data_start; // start after header row
+    // std::vector<std::string_view> current_row;
+    // current_row.reserve(col_num);
+    auto current_row = std::make_unique<std::string_view[]>(out_cols);
+    detail::row_sink<RowCallback> out{current_row.get(), callback};
+    run(out);
+}
+
+template <typename BlockCallback>
+void csv::CsvReader::parse_blocks(const size_t block_rows, const BlockCallback &callback) {
+    if (block_rows == 0) {
+        throw std::invalid_argument("block_rows must be positive");
+    }
+    block_bytes.reset();
+    detail::block_sink<BlockCallback> out(out_cols, block_rows, callback, f_stream ? nullptr : &block_bytes);
+    run(out);
+}
+
+template <typename BatchCallback>
+void csv::CsvReader::parse_columns(const size_t batch_rows, const BatchCallback &callback) {
+    detail::column_sink<BatchCallback> out(selected_headers(), batch_rows, callback, f_stream == nullptr);
+    run(out);
+}
+
+template <typename BatchCallback>
+void csv::CsvReader::parse_typed(const csv::schema &schema, const size_t batch_rows, const BatchCallback &callback) {
+    std::vector<std::string> names;
+    names.reserve(schema.size());
+    for (const auto& spec : schema) {
+        names.push_back(spec.name);
+    }
+
+    ProjectionGuard guard{*this, slots, out_cols, skip_from};
+
+    select_columns(names);
+    csv::TypedBatch typed(schema);
+    parse_columns(batch_rows, [&](const csv::ColumnBatch& batch) {
+        typed.decode(batch);
+        callback(static_cast<const csv::TypedBatch&>(typed));
+    });
+}
+
+csv::profile csv::CsvReader::infer(const infer_options options) {
+    if (!f_map) {
+        throw std::runtime_error("infer requires a mapped file");
+    }
+    ProjectionGuard guard{*this, slots, out_cols, skip_from};
+    select_columns(std::vector<int>{});
+
+    std::vector<detail::column_profiler> columns(col_num);
+    csv::profile result;
+    auto add = [&](const std::string_view* row) {
+        for (int c = 0; c < col_num; c++) {
+            columns[c].add(row[c]);
+        }
+        result.rows++;
+    };
+    auto current_row = std::make_unique<std::string_view[]>(out_cols);
+    detail::row_sink<decltype(add)> out{current_row.get(), add};
+    auto no_progress = [](const char*) {};
+
+    // windows at evenly spaced seek points, only the pages they touch are read
+    // a window starting late runs up to sample_bytes past the next seek point, it is cut at the
+    // next window's first row so no row is sampled twice
+    const size_t total = end - data_start;
+    result.complete = options.samples == 0 || total / options.samples <= options.sample_bytes;
+    if (result.complete) {
+        parse_rows(data_start, end, true, out, no_progress);
+    } else {
+        const size_t spacing = total / options.samples;
+        const char* begin = data_start;
+        for (size_t i = 0; i < options.samples; i++) {
+            const char* next = i + 1 < options.samples
+                                   ? sample_start(data_start + (i + 1) * spacing, options.sample_bytes)
+                                   : end;
+            const char* stop = std::min({begin + options.sample_bytes, next, end});
+            if (begin < stop) {
+                parse_rows(begin, stop, stop == end, out, no_progress);
+            }
+            begin = next;
+        }
+    }
+
+    result.columns.reserve(col_num);
+    for (int c = 0; c < col_num; c++) {
+        result.columns.push_back(columns[c].result(headers[c]));
+    }
+    return result;
+}
+
+template <typename RowCallback>
+void csv::CsvReader::parse_range(const size_t first_row, size_t count, const RowCallback &callback) {
+    if (!f_map) {
+        throw std::runtime_error("parse_range requires a mapped file");
+    }
+    if (!row_index) {
+        use_index(index_stride ? index_stride : INDEX_STRIDE);
+        if (!row_index) build_index(index_stride);
+    }
+    const csv::RowIndex& index = *row_index;
+    if (first_row >= index.rows() || count == 0) {
+        return;
+    }
+    count = std::min<uint64_t>(count, index.rows() - first_row);
+
+    // restart at the sample before first_row, stop at the sample after the last row
+    const size_t first_sample = first_row / index.stride();
+    const size_t last_sample = (first_row + count + index.stride() - 1) / index.stride();
+    const char* base = f_map->data();
+    const char* begin = base + index.offset(first_sample);
+    const char* stop = last_sample < index.samples() ? base + index.offset(last_sample) : end;
+
+    auto current_row = std::make_unique<std::string_view[]>(out_cols);
+    detail::row_sink<RowCallback> rows{current_row.get(), callback};
+    detail::range_sink<decltype(rows)> out{rows, first_row - first_sample * index.stride(), count};
+    parse_rows(begin, stop, true, out, [](const char*) {});
+}
+
+csv::checkpoint csv::CsvReader::begin_checkpoint() const {
+    if (!f_map) {
+        throw std::runtime_error("Checkpoints require a mapped file");
+    }
+    csv::checkpoint start;
+    start.offset = data_start - f_map->data();
+    start.stamp = current_stamp();
+    start.inode = csv::inode_of(file_path);
+    return start;
+}
+
+template <typename RowCallback, typename CheckpointCallback>
+void csv::CsvReader::parse_from(const csv::checkpoint &from, const RowCallback &callback,
+                                const CheckpointCallback &on_checkpoint) {
+    const csv::checkpoint start = begin_checkpoint();
+    if (!(from.stamp == start.stamp) || from.inode != start.inode
+        || from.offset < start.offset || from.offset > f_map->size()) {
+        throw std::invalid_argument("Checkpoint does not match the file");
+    }
+
+    bool requested = false;
+    auto on_row = [&](const std::string_view* row) {
+        if constexpr (std::is_void_v<decltype(callback(row))>) {
+            callback(row);
+        } else {
+            if (callback(row)) requested = true;
+        }
+    };
+    auto current_row = std::make_unique<std::string_view[]>(out_cols);
+    detail::row_sink<decltype(on_row)> rows{current_row.get(), on_row};
+    detail::checkpoint_sink<decltype(rows), CheckpointCallback> out{rows, on_checkpoint, requested,
+                                                                    f_map->data(), from};
+    run(out, f_map->data() + from.offset);
+    // the last row had no newline, so no row start followed it
+    if (requested) out.row_start(end);
+}
+
+template <typename RowCallback>
+void csv::CsvReader::parse_from(const csv::checkpoint &from, const RowCallback &callback) {
+    parse_from(from, callback, [](const csv::checkpoint&) {});
+}
+
+template <typename RowCallback>
+void csv::CsvReader::parse_encoded(const std::vector<std::string> &names, const RowCallback &callback) {
+    const std::vector<std::string> selected = selected_headers();
+    std::vector<int> positions;
+    positions.reserve(names.size());
+    for (const auto& name : names) {
+        const auto it = std::find(selected.begin(), selected.end(), name);
+        if (it == selected.end()) {
+            throw std::invalid_argument("Encoded column is not selected: " + name);
+        }
+        positions.push_back(static_cast<int>(it - selected.begin()));
+    }
+    encoded_names = names;
+    dictionaries.clear();
+    dictionaries.resize(names.size());
+
+    const size_t count = positions.size();
+    std::vector<uint32_t> codes(count);
+    auto on_row = [&](const std::string_view* row) {
+        for (size_t i = 0; i < count; i++) {
+            codes[i] = dictionaries[i].encode(row[positions[i]]);
+        }
+        callback(row, static_cast<const uint32_t*>(codes.data()));
+    };
+    auto current_row = std::make_unique<std::string_view[]>(out_cols);
+    detail::row_sink<decltype(on_row)> out{current_row.get(), on_row};
+    run(out);
+}
+
+const csv::Dictionary* csv::CsvReader::dictionary(const std::string &name) const {
+    const auto it = std::find(encoded_names.begin(), encoded_names.end(), name);
+    return it == encoded_names.end() ? nullptr : &dictionaries[it - encoded_names.begin()];
+}
+
+csv::group_table csv::CsvReader::group_by(const csv::group_query &query, parallel_options options) {
+    // read the key and every value column once, value[a] = slot of aggregate a's column or -1
+    std::vector<std::string> names{query.key};
+    std::vector<int> value;
+    for (const auto& agg : query.aggregates) {
+        if (agg.column.empty()) {
+            if (agg.op != csv::aggregate::kind::count) {
+                throw std::invalid_argument("Aggregate needs a column: " + agg.name());
+            }
+            value.push_back(-1);
+            continue;
+        }
+        auto it = std::find(names.begin(), names.end(), agg.column);
+        if (it == names.end()) it = names.insert(names.end(), agg.column);
+        value.push_back(static_cast<int>(it - names.begin()));
+    }
+
+    ProjectionGuard guard{*this, slots, out_cols, skip_from};
+    select_columns(names);
+
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0 || !f_map) threads = 1;
+    const size_t width = value.size();
+    const size_t columns = names.size();
+    std::vector<detail::group_partial> partials;
+    partials.reserve(threads);
+    for (unsigned w = 0; w < threads; w++) partials.emplace_back(width);
+
+    // numbers[worker][c]: row[c] parsed once per row, NaN when it is not a number
+    const bool key_value = std::find(value.begin(), value.end(), 0) != value.end();
+    std::vector<std::vector<double>> numbers(threads, std::vector<double>(columns));
+
+    auto add = [&](const unsigned worker, const std::string_view* row) {
+        double* number = numbers[worker].data();
+        for (size_t c = key_value ? 0 : 1; c < columns; c++) {
+            if (!detail::parse_number(row[c], number[c])) {
+                number[c] = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+        detail::agg_state* states = partials[worker].group(row[0]);
+        for (size_t a = 0; a < width; a++) {
+            if (value[a] < 0) states[a].count++;
+            else if (!std::isnan(number[value[a]])) states[a].add(number[value[a]]);
+        }
+    };
+    if (f_map) {
+        options.ordered = false;
+        options.threads = threads;
+        parse_parallel(add, options);
+    } else {
+        parse([&](const std::string_view* row) { add(0, row); });
+    }
+
+    for (unsigned w = 1; w < threads; w++) {
+        partials[0].merge(partials[w]);
+    }
+    return partials[0].result(query);
+}
+
+template <typename Sink>
+void csv::CsvReader::run(Sink &out, const char* begin) {
+    if (f_stream) {
+        run_stream(out);
+        return;
+    }
+    if (begin == nullptr) begin = data_start;
+
+    // index requested but not loaded: sample row starts during this parse
+    if constexpr (!detail::has_row_start<Sink>::value) {
+        if (index_stride != 0 && !row_index && begin == data_start) {
+            auto index = std::make_unique<csv::RowIndex>(index_stride);
+            index->add(data_start - f_map->data());
+            detail::index_sink<Sink> indexed{out, *index, f_map->data()};
+            run(indexed);
+            index->finish(indexed.rows);
+            row_index = std::move(index);
+            save_index();
+            return;
+        }
+    }
+
+    detail::stats_scope scope(stats_state.get());
+
+    // MAP_POPULATE already read and mapped every page, nothing left to prefetch
+    if (io == csv::io_mode::mmap_populate) {
+        parse_rows(begin, end, true, out, [](const char*) {});
+        out.flush();
+        return;
+    }
 
     // PREFETCH THREAD
-    // Track parser progress so prefetcher stays ahead
-    std::mutex prefetch_mtx;
-    std::condition_variable prefetch_cv;
-    bool advance_signal = false; // guarded by prefetch_mtx
-    bool done = false; // guarded by prefetch_mtx
+    // keeps [parser, parser + prefetch_distance) in: it refills the window once the parser used a
+    // quarter of it and futex-sleeps in between, the parser only publishes its position
+    detail::progress parsed;
+    // SIMDCSV_STATS: last page the prefetcher brought in, compared with the parser position
+    std::atomic<const char*> prefetched{begin};
+    csv::parse_stats timing;
+    uint64_t last_progress = STATS_ENABLED ? detail::now_ns() : 0;
 
     // RAII guard
     struct ThreadGuard {
         std::thread& t;
-        std::mutex& mtx;
-        std::condition_variable& cv;
-        bool& done_flag;
+        detail::progress& parsed;
 
         ThreadGuard(const ThreadGuard&) = delete;
         ThreadGuard& operator=(const ThreadGuard&) = delete;
@@ -118,11 +919,7 @@ void csv::CsvReader::parse(const RowCallback &callback) {
         ThreadGuard& operator=(ThreadGuard&&) = delete;
 
         ~ThreadGuard() {
-            {
-                std::lock_guard lock(mtx);
-                done_flag = true;
-            }
-            cv.notify_one();
+            parsed.finish();
             if (t.joinable()) {
                 t.join();
             }
@@ -131,214 +928,912 @@ void csv::CsvReader::parse(const RowCallback &callback) {
 
     std::thread prefetcher([&]() {
         volatile char sink = 0;  // prevent optimization
-        const char* prefetch_ptr = data_start;
-        const char* local_target = std::min(data_start + PREFETCH_CHUNK, end);
+        const size_t total = end - begin;
+        const size_t distance = prefetch_distance;
+        const size_t refill = std::max(distance / 4, PAGE_SIZE);
+        size_t ahead = 0;  // next offset to bring in
 
-        while (true) {
-            // Touch pages to trigger page faults ahead of parser
-            while (prefetch_ptr < local_target) {
-                sink += *prefetch_ptr;  // page fault
-                prefetch_ptr += PAGE_SIZE;
+        while (ahead < total) {
+            const size_t target = std::min(parsed.position() + distance, total);
+            if (ahead < target) {
+                if (prefetch == csv::prefetch_mode::willneed) {
+                    f_map->willneed(begin + ahead, target - ahead);
+                    ahead = target;
+                } else {
+                    // touch pages to trigger page faults ahead of parser
+                    for (; ahead < target; ahead += PAGE_SIZE) sink += begin[ahead];
+                }
+                if constexpr (STATS_ENABLED) prefetched.store(begin + std::min(ahead, total), std::memory_order_relaxed);
+                continue;
             }
+            // window full: sleep until the parser used refill bytes of it
+            if (!parsed.wait(ahead - distance + refill)) break;
+        }
+        (void)sink;  // suppress unused warning
+    });
+
+    ThreadGuard guard{prefetcher, parsed};
+
+    parse_rows(begin, end, true, out, [&](const char* pos) {
+        if constexpr (STATS_ENABLED) {
+            const uint64_t now = detail::now_ns();
+            (pos > prefetched.load(std::memory_order_relaxed) ? timing.ahead_ns : timing.behind_ns)
+                    += now - last_progress;
+            last_progress = now;
+        }
+        parsed.advance(pos - begin);
+    });
+    if constexpr (STATS_ENABLED) {
+        const uint64_t start = detail::now_ns();
+        out.flush();
+        timing.callback_ns += detail::now_ns() - start;
+        stats_state->add(timing);
+    } else {
+        out.flush();
+    }
+}
+
+template <typename Sink>
+void csv::CsvReader::run_stream(Sink &out) {
+    if (stream_consumed) {
+        throw std::runtime_error("Stream already consumed");
+    }
+    stream_consumed = true;
+    detail::stats_scope scope(stats_state.get());
 
-            if (prefetch_ptr >= end) break;
+    const char* begin = data_start;
 
-            // sleep
-            {
-                std::unique_lock<std::mutex> lock(prefetch_mtx);
-                prefetch_cv.wait(lock, [&] {
-                    return advance_signal || done;
-                });
+    // rows are zero-copy views into the buffer, only the row cut by the end of a read is moved
+    while (true) {
+        const bool last = f_stream->eof();
+        begin = parse_rows(begin, end, last, out, [](const char*) {});
+        out.flush();
+        if (last) break;
+
+        f_stream->fill(begin);
+        begin = f_stream->data();
+        end = begin + f_stream->size();
+    }
+    data_start = end;
+}
 
-                if (done) break;
-                advance_signal = false;
+template <typename RowCallback>
+csv::follow_state csv::CsvReader::follow(const RowCallback &callback, const follow_options options) {
+    if (!f_map) {
+        throw std::runtime_error("follow requires a mapped file");
+    }
+    csv::file::FWatch watch(file_path);
+    detail::stats_scope scope(stats_state.get());
+
+    csv::follow_state state;
+    auto counted = [&](const std::string_view* row) {
+        state.rows++;
+        callback(row);
+    };
+    // the row buffer is sized once the header row is complete
+    std::unique_ptr<std::string_view[]> current_row;
+    detail::row_sink<decltype(counted)> out{nullptr, counted};
+    uint64_t next = 0;   // offset of the next row start
+    auto idle_since = std::chrono::steady_clock::now();
+
+    while (true) {
+        const bool grew = grow_mapping();
+        if (grew && header_pending) {
+            // the header row was cut by the end of file: read it again, the projection and
+            // filters built on the partial header are reset
+            headers.clear();
+            header_pending = !parse_header_row(f_map->data());
+            if (!header_pending) {
+                select_columns(std::vector<int>{});
+                clear_filters();
             }
+        }
+        if (!header_pending) {
+            if (!current_row) {
+                if (options.offset > f_map->size()) {
+                    throw std::invalid_argument("follow offset past the end of file");
+                }
+                current_row = std::make_unique<std::string_view[]>(out_cols);
+                out.current_row = current_row.get();
+                next = options.offset ? options.offset : static_cast<uint64_t>(data_start - f_map->data());
+            }
+            const char* begin = f_map->data() + next;
+            if (begin < end) {
+                next = parse_rows(begin, end, false, out, [](const char*) {}) - f_map->data();
+            }
+            state.offset = next;
+        }
 
-            local_target = std::min(prefetch_ptr + PREFETCH_CHUNK, end);
+        if (options.stop && options.stop->load(std::memory_order_relaxed)) break;
+        const auto now = std::chrono::steady_clock::now();
+        if (grew) {
+            idle_since = now;
+            continue;
         }
-        (void)sink;  // suppress unused warning
-    });
+        if (options.idle.count() > 0 && now - idle_since >= options.idle) break;
+        watch.wait(options.poll);
+    }
+    return state;
+}
 
-    ThreadGuard guard{prefetcher, prefetch_mtx, prefetch_cv, done};
+bool csv::CsvReader::grow_mapping() {
+    const char* base = f_map->data();
+    const size_t start = data_start - base;
+    if (!f_map->grow()) {
+        return false;
+    }
+    data_start = f_map->data() + start;
+    end = f_map->data() + f_map->size();
+    return true;
+}
 
-    const __m256i v_comma = _mm256_set1_epi8(format.delimiter);
-    const __m256i v_newline = _mm256_set1_epi8(format.new_line);
-    const __m256i v_quote = format.quote.has_value() ? _mm256_set1_epi8(format.quote.value()) : _mm256_setzero_si256();
+template <typename RowCallback>
+void csv::CsvReader::parse_parallel(const RowCallback &callback, parallel_options options) {
+    if (!f_map) {
+        throw std::runtime_error("parse_parallel requires a mapped file");
+    }
 
-    // std::vector<std::string_view> current_row;
-    // current_row.reserve(col_num);
-    auto current_row = std::make_unique<std::string_view[]>(col_num);
-    int col_idx = 0;
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
 
-    const char* field_start = ptr;
-    uint32_t in_quote = 0;
-
-    // loop with step 32 bytes
-    while (ptr + 32 <= end) {
-        // load 32 bytes into register
-        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
-
-        // find comma, new line, quote parallel
-        const __m256i cmp_comma = _mm256_cmpeq_epi8(chunk, v_comma);
-        const __m256i cmp_newline = _mm256_cmpeq_epi8(chunk, v_newline);
-
-        uint32_t quote_mask = 0;
-        uint32_t quote_solid_mask = 0;
-
-        if (format.quote.has_value()) {
-            const __m256i cmp_quote = _mm256_cmpeq_epi8(chunk, v_quote);
-            quote_mask = _mm256_movemask_epi8(cmp_quote);
-
-            // if in_quote = 1 -> (0 - 1) = -1 = 0xFFFFFFFF -> XOR result is NOT mask
-            // if in_quote = 0 -> (0 - 0) = 0  = 0x00000000 -> XOR result is mask (keep)
-            quote_solid_mask = prefix_xor(quote_mask);
-            quote_solid_mask ^= (0 - in_quote);
-            // calculate in_quote for next loop
-            // if number of quote is odd, XOR with 1
-            // else XOR with 0
-            in_quote ^= (_mm_popcnt_u32(quote_mask) & 1);
-        }
-
-        // convert result to bitmask 32bit
-        const uint32_t comma_mask = _mm256_movemask_epi8(cmp_comma);
-        const uint32_t newline_mask = _mm256_movemask_epi8(cmp_newline);
-
-        const uint32_t valid_comma_mask = comma_mask & ~quote_solid_mask;
-        const uint32_t valid_newline_mask = newline_mask & ~quote_solid_mask;
-
-        // get comma outside solid mask (outside quotation)
-        uint32_t valid_sep_mask = valid_comma_mask | valid_newline_mask;
-
-        while (valid_sep_mask != 0) {
-            const int offset = __builtin_ctz(valid_sep_mask);
-            const char* found_pos = ptr +offset;
-            
-            if (col_idx < col_num) {
-                current_row[col_idx] = trim_quotes(std::string_view(field_start, found_pos - field_start), format);
-            }
-            col_idx++;
-
-            // check current char is newline
-            if ((valid_newline_mask >> offset) & 1) {
-                // Lazy clear: only clear unfilled fields if row has fewer columns
-                if (col_idx < col_num) {
-                    for (int i = col_idx; i < col_num; i++) {
-                        current_row[i] = std::string_view();
-                    }
+    const size_t total = end - data_start;
+    size_t chunk_size = options.chunk_size;
+    if (chunk_size == 0) {
+        // several chunks per worker for load balance, ordered mode keeps chunks small to bound buffering
+        chunk_size = total / (threads * 4) + 1;
+        chunk_size = std::clamp<size_t>(chunk_size, 1 << 20, options.ordered ? 4 << 20 : PREFETCH_CHUNK);
+    }
+    const size_t chunk_count = total == 0 ? 0 : (total + chunk_size - 1) / chunk_size;
+    if (chunk_count == 0) return;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, chunk_count));
+    detail::stats_scope scope(stats_state.get());
+
+    // PASS 1: quote parity of every chunk, prefix XOR gives the exact quote state at each split point
+    std::vector<uint32_t> chunk_quote(chunk_count, 0);
+    if (format.quote.has_value()) {
+        std::atomic<size_t> next{0};
+        detail::run_workers(threads, [&](unsigned) {
+            for (size_t c; (c = next.fetch_add(1, std::memory_order_relaxed)) < chunk_count;) {
+                const char* b = data_start + c * chunk_size;
+                chunk_quote[c] = quote_parity(b, std::min(b + chunk_size, end));
+            }
+        });
+        uint32_t in_quote = 0;
+        for (size_t c = 0; c < chunk_count; c++) {
+            const uint32_t parity = chunk_quote[c];
+            chunk_quote[c] = in_quote;
+            in_quote ^= parity;
+        }
+    }
+
+    // chunk c owns the rows starting in [row_start(c), row_start(c + 1))
+    auto row_start = [&](size_t c) -> const char* {
+        if (c == 0) return data_start;
+        if (c >= chunk_count) return end;
+        return next_row_start(data_start + c * chunk_size, chunk_quote[c]);
+    };
+
+    // PASS 2: parse chunks
+    std::atomic<size_t> next{0};
+    std::mutex turn_mtx;
+    std::condition_variable turn_cv;
+    size_t turn = 0; // guarded by turn_mtx, next chunk allowed to deliver in ordered mode
+    std::atomic<bool> failed{false};  // a callback threw: the other workers quit
+
+    detail::run_workers(threads, [&](unsigned worker) {
+        auto current_row = std::make_unique<std::string_view[]>(out_cols);
+        std::vector<std::string_view> buffered;
+        auto no_progress = [](const char*) {};
+        // ordered mode: rows (and their unescaped fields) are held until the chunk's turn
+        auto keep = [&](const std::string_view* row) {
+            buffered.insert(buffered.end(), row, row + out_cols);
+        };
+        detail::row_sink<decltype(keep), true> kept{current_row.get(), keep};
+
+        // ordered mode: workers waiting for the failed chunk's turn must be woken
+        struct FailGuard {
+            std::mutex& mtx;
+            std::condition_variable& cv;
+            std::atomic<bool>& failed;
+            bool armed = true;
+            ~FailGuard() {
+                if (!armed) return;
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    failed.store(true, std::memory_order_relaxed);
                 }
-                callback(current_row.get());
-                col_idx = 0;
+                cv.notify_all();
             }
-            field_start = found_pos + 1;
+        } fail_guard{turn_mtx, turn_cv, failed};
 
-            // mark processed pos to 0
-            valid_sep_mask &= ~(1u << offset);
-        }
+        for (size_t c; !failed.load(std::memory_order_relaxed)
+                       && (c = next.fetch_add(1, std::memory_order_relaxed)) < chunk_count;) {
+            const char* begin = row_start(c);
+            const char* stop = row_start(c + 1);
+
+            if (!options.ordered) {
+                if (begin < stop) {
+                    auto deliver = [&](const std::string_view* row) {
+                        callback(worker, row);
+                    };
+                    detail::row_sink<decltype(deliver)> out{current_row.get(), deliver};
+                    parse_rows(begin, stop, true, out, no_progress);
+                }
+                continue;
+            }
 
-        ptr += 32;
+            buffered.clear();
+            kept.scratch.reset();
+            if (begin < stop) {
+                parse_rows(begin, stop, true, kept, no_progress);
+            }
 
-        // Update parser position for prefetcher (every 64KB to reduce overhead)
-        if ((reinterpret_cast<uintptr_t>(ptr) & 0xFFFF) == 0) {
-            {
-                std::lock_guard<std::mutex> lock(prefetch_mtx);
-                advance_signal = true;
+            // wait for previous chunks, then deliver in file order
+            std::unique_lock<std::mutex> lock(turn_mtx);
+            turn_cv.wait(lock, [&] { return turn == c || failed.load(std::memory_order_relaxed); });
+            if (turn != c) break;
+            for (size_t i = 0; i < buffered.size(); i += out_cols) {
+                callback(worker, buffered.data() + i);
             }
-            prefetch_cv.notify_one(); // wakeup prefetcher
+            turn++;
+            lock.unlock();
+            turn_cv.notify_all();
         }
+        fail_guard.armed = false;
+    });
+}
+
+template <typename Sink, typename Progress>
+const char* csv::CsvReader::parse_rows(const char* begin, const char* stop, const bool last, Sink& out,
+                                       const Progress& progress) const {
+    const bool unescape = format.unescape && format.quote.has_value();
+    if (filters.empty()) {
+        return unescape ? scan_rows<false, true>(begin, stop, last, out, progress)
+                        : scan_rows<false, false>(begin, stop, last, out, progress);
     }
+    return unescape ? scan_rows<true, true>(begin, stop, last, out, progress)
+                    : scan_rows<true, false>(begin, stop, last, out, progress);
+}
 
-    // remain bytes
-    while (ptr < end) {
-        char c = *ptr;
-        if (format.quote.has_value() && c == format.quote.value()) {
-            in_quote = !in_quote;
-        } else if (!in_quote) {
-            if (c == format.delimiter || c == format.new_line) {
-                if (col_idx < col_num) {
-                    current_row[col_idx] = trim_quotes(std::string_view(field_start, ptr - field_start), format);
+template <bool Filtered, bool Unescape, typename Sink, typename Progress>
+const char* csv::CsvReader::scan_rows(const char* begin, const char* stop, const bool last, Sink& out,
+                                      const Progress& progress) const {
+    const char* ptr = begin;
+    const char* row_start = begin;
+
+    const csv::simd::kernel& kernel = csv::simd::active();
+    const csv::simd::pattern pat = simd_pattern();
+    csv::simd::block_masks masks[csv::simd::WINDOW_BLOCKS];
+
+    int col_idx = 0;
+
+    const char* field_start = ptr;
+    uint64_t in_quote = 0;
+
+    const int* slot = slots.data();
+    const int* filter = filter_at.data();
+    // fields from here on are neither selected nor filtered
+    const int skip_at = Filtered ? std::max(skip_from, filter_from) : skip_from;
+    // true while the rest of the row holds no selected field
+    bool skipping = false;
+    // a filter rejected the current row, its remaining fields are skipped
+    bool dropped = false;
+    // quote chars of the current field seen in earlier blocks, more than 2 = escaped quotes inside
+    uint64_t field_quotes = 0;
+
+    // SIMDCSV_STATS, compiled away otherwise
+    csv::parse_stats counted;
+    int row_fields = 0;
+    uint64_t kernel_ticks = 0;
+    uint64_t callback_ticks = 0;
+    const detail::tick_clock clock;
+
+    // a '\r' ending an unfinished buffer may be the first half of "\r\n": leave it to the next read
+    if (pat.lone_cr && !last && begin < stop && stop[-1] == '\r') {
+        stop--;
+    }
+
+    // stage 1: kernel resolves delimiter/newline/quote masks for a window of 64-byte blocks
+    // stage 2: walk the separator bits
+    while (ptr < stop) {
+        const size_t remain = stop - ptr;
+        size_t blocks = std::min(remain / csv::simd::BLOCK, csv::simd::WINDOW_BLOCKS);
+        size_t scanned = blocks * csv::simd::BLOCK;
+
+        detail::timed(kernel_ticks, [&]() {
+            if (blocks > 0) {
+                in_quote = kernel.scan(ptr, blocks, pat, in_quote, masks);
+            } else {
+                // remain bytes: pad into one zeroed block, drop bits past the end
+                alignas(64) char tail[csv::simd::BLOCK] = {};
+                std::memcpy(tail, ptr, remain);
+                in_quote = kernel.scan(tail, 1, pat, in_quote, masks);
+                const uint64_t valid = (1ull << remain) - 1;
+                masks[0].sep &= valid;
+                masks[0].newline &= valid;
+                masks[0].quote &= valid;
+                masks[0].cr &= valid;
+                blocks = 1;
+                scanned = remain;
+            }
+            if (pat.crlf) {
+                csv::simd::resolve_crlf(masks, blocks, ptr > begin && ptr[-1] == '\r',
+                                        ptr + scanned < stop && ptr[scanned] == '\n', pat.lone_cr);
+            }
+        });
+        if constexpr (STATS_ENABLED) counted.bytes += scanned;
+
+        const char* block_ptr = ptr;
+        for (size_t b = 0; b < blocks; b++, block_ptr += csv::simd::BLOCK) {
+            if constexpr (STATS_ENABLED) tally_block(masks[b], row_fields, counted);
+            const uint64_t valid_newline_mask = masks[b].newline;
+            const uint64_t crlf_mask = masks[b].cr;
+            uint64_t valid_sep_mask = masks[b].sep;
+            uint64_t quote_mask = Unescape ? masks[b].quote : 0;
+            if (skipping) {
+                valid_sep_mask = skip_to_newline(valid_sep_mask, valid_newline_mask, skipping);
+            }
+
+            while (valid_sep_mask != 0) {
+                const int offset = __builtin_ctzll(valid_sep_mask);
+                const char* found_pos = block_ptr + offset;
+                // the '\n' of "\r\n": the field ends at the '\r'
+                const char* field_end = found_pos - ((crlf_mask >> offset) & 1);
+
+                uint64_t quotes = 0;
+                if constexpr (Unescape) {
+                    // most fields hold no quote at all, popcount only when one is there
+                    const uint64_t in_field = quote_mask & ((1ull << offset) - 1);
+                    quotes = field_quotes + (in_field ? __builtin_popcountll(in_field) : 0);
+                    quote_mask &= ~((2ull << offset) - 1);
+                    field_quotes = 0;
                 }
-                col_idx++;
-                if (c == format.new_line) {
-                    // Lazy clear: only clear unfilled fields if row has fewer columns
-                    if (col_idx < col_num) {
-                        for (int i = col_idx; i < col_num; i++) {
-                            current_row[i] = std::string_view();
+
+                if (col_idx < col_num && (!Filtered || !dropped)) {
+                    if (slot[col_idx] >= 0 || (Filtered && filter[col_idx] >= 0)) {
+                        const std::string_view value = field_value<Unescape>(
+                            std::string_view(field_start, field_end - field_start), quotes, out);
+                        if (slot[col_idx] >= 0) {
+                            out.field(slot[col_idx], value);
+                        }
+                        if (Filtered && filter[col_idx] >= 0) {
+                            dropped = !accept(col_idx, value);
                         }
                     }
-                    callback(current_row.get());
+                }
+                col_idx++;
+                field_start = found_pos + 1;
+
+                // mark processed pos to 0
+                valid_sep_mask &= valid_sep_mask - 1;
+
+                // check current char is newline
+                if ((valid_newline_mask >> offset) & 1) {
+                    detail::timed(callback_ticks, [&]() { end_row(out, col_idx, dropped); });
                     col_idx = 0;
+                    dropped = false;
+                    row_start = found_pos + 1;
+                    if constexpr (detail::has_row_start<Sink>::value) {
+                        out.row_start(row_start);
+                    }
+                } else if (col_idx == skip_at || (Filtered && dropped)) {
+                    // no selected or filtered column left in this row: jump to its newline
+                    skipping = true;
+                    valid_sep_mask = skip_to_newline(valid_sep_mask, valid_newline_mask, skipping);
                 }
-                field_start = ptr + 1;
+            }
+            if (Unescape && quote_mask != 0) {
+                field_quotes += __builtin_popcountll(quote_mask);
             }
         }
-        ptr++;
+
+        // Update parser position for prefetcher (every 64KB to reduce overhead)
+        if (((reinterpret_cast<uintptr_t>(ptr) ^ reinterpret_cast<uintptr_t>(ptr + scanned)) >> 16) != 0) {
+            progress(ptr + scanned);
+        }
+        ptr += scanned;
+    }
+
+    // unfinished row, caller brings more data
+    if (!last) {
+        if constexpr (STATS_ENABLED) add_stats(counted, clock, kernel_ticks, callback_ticks);
+        return row_start;
     }
 
     // Flush last line (if file doesn't end with newline)
-    if (field_start < end) {
-        if (col_idx < col_num) {
-            current_row[col_idx] = trim_quotes(std::string_view(field_start, end - field_start), format);
+    if (field_start < stop) {
+        if (col_idx < col_num && !dropped) {
+            const std::string_view value = field_value<Unescape>(
+                std::string_view(field_start, stop - field_start), field_quotes, out);
+            if (slot[col_idx] >= 0) {
+                out.field(slot[col_idx], value);
+            }
+            if (Filtered && filter[col_idx] >= 0) {
+                dropped = !accept(col_idx, value);
+            }
         }
         col_idx++;
     }
     if (col_idx > 0) {
-        // Lazy clear: only clear unfilled fields if last row has fewer columns
-        if (col_idx < col_num) {
-            for (int i = col_idx; i < col_num; i++) {
-                current_row[i] = std::string_view();
+        detail::timed(callback_ticks, [&]() { end_row(out, col_idx, dropped); });
+    }
+    if constexpr (STATS_ENABLED) {
+        if (row_start < stop) tally_row(row_fields + 1, counted);
+        add_stats(counted, clock, kernel_ticks, callback_ticks);
+    }
+    return stop;
+}
+
+template <bool Unescape, typename Sink>
+std::string_view csv::CsvReader::field_value(const std::string_view raw, const uint64_t quotes, Sink &out) const {
+    if constexpr (Unescape) {
+        const char quote = *format.quote;
+        if (quotes > 2 && raw.size() >= 2 && raw.front() == quote && raw.back() == quote) {
+            return detail::unescape(raw, quote, out.arena());
+        }
+    }
+    return trim_quotes(raw, format);
+}
+
+template <typename Sink>
+void csv::CsvReader::end_row(Sink &out, const int fields, bool dropped) const {
+    for (int i = fields; i < filter_from && !dropped; i++) {
+        if (filter_at[i] >= 0) {
+            dropped = !accept(i, std::string_view());
+        }
+    }
+    if (dropped) {
+        out.drop();
+        return;
+    }
+
+    // Lazy clear: only clear unfilled fields if row has fewer columns
+    // every selected column sits below skip_from
+    for (int i = fields; i < skip_from; i++) {
+        if (slots[i] >= 0) {
+            out.field(slots[i], std::string_view());
+        }
+    }
+    out.row(fields);
+}
+
+bool csv::CsvReader::accept(const int col, const std::string_view value) const {
+    for (int f = filter_at[col]; f >= 0; f = filters[f].next) {
+        if (!filters[f].matches(value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void csv::CsvReader::tally_block(const csv::simd::block_masks &masks, int &row_fields, csv::parse_stats &s) const {
+    uint64_t nl = masks.newline;
+    uint64_t delim = masks.sep & ~nl;
+    while (nl != 0) {
+        const uint64_t before = (nl & (0 - nl)) - 1;
+        row_fields += __builtin_popcountll(delim & before);
+        delim &= ~before;
+        tally_row(row_fields + 1, s);
+        row_fields = 0;
+        nl &= nl - 1;
+    }
+    row_fields += __builtin_popcountll(delim);
+    s.quoted_blocks += masks.quote != 0;
+}
+
+void csv::CsvReader::tally_row(const int fields, csv::parse_stats &s) const {
+    s.rows++;
+    s.fields += fields;
+    s.short_rows += fields < col_num;
+    s.long_rows += fields > col_num;
+}
+
+void csv::CsvReader::add_stats(csv::parse_stats &s, const detail::tick_clock &clock,
+                               const uint64_t kernel_ticks, const uint64_t callback_ticks) const {
+    const double ns_per_tick = clock.ns_per_tick();
+    s.kernel_ns = static_cast<uint64_t>(static_cast<double>(kernel_ticks) * ns_per_tick);
+    s.callback_ns = static_cast<uint64_t>(static_cast<double>(callback_ticks) * ns_per_tick);
+    stats_state->add(s);
+}
+
+csv::parse_stats csv::CsvReader::stats() const {
+    if (!stats_state) return {};
+    std::lock_guard lock(stats_state->mtx);
+    return stats_state->total;
+}
+
+void csv::CsvReader::reset_stats() {
+    if (!stats_state) return;
+    std::lock_guard lock(stats_state->mtx);
+    stats_state->total = {};
+}
+
+uint64_t csv::CsvReader::skip_to_newline(const uint64_t sep_mask, const uint64_t newline_mask, bool &skipping) {
+    const uint64_t newlines = sep_mask & newline_mask;
+    if (newlines == 0) {
+        return 0;
+    }
+    skipping = false;
+    // keep the first newline and everything after it
+    return sep_mask & ~((newlines & (0 - newlines)) - 1);
+}
+
+void csv::CsvReader::select_columns(const std::vector<int> &columns) {
+    slots.assign(col_num, -1);
+    if (columns.empty()) {
+        for (int i = 0; i < col_num; i++) slots[i] = i;
+        out_cols = col_num;
+        skip_from = col_num;
+        return;
+    }
+
+    skip_from = 0;
+    for (size_t i = 0; i < columns.size(); i++) {
+        const int col = columns[i];
+        if (col < 0 || col >= col_num) {
+            throw std::out_of_range("Column index out of range");
+        }
+        if (slots[col] >= 0) {
+            throw std::invalid_argument("Column selected twice");
+        }
+        slots[col] = static_cast<int>(i);
+        skip_from = std::max(skip_from, col + 1);
+    }
+    out_cols = static_cast<int>(columns.size());
+}
+
+void csv::CsvReader::select_columns(const std::vector<std::string> &names) {
+    std::vector<int> columns;
+    columns.reserve(names.size());
+    for (const auto& name : names) {
+        const auto it = std::find(headers.begin(), headers.end(), name);
+        if (it == headers.end()) {
+            throw std::invalid_argument("Unknown column: " + name);
+        }
+        columns.push_back(static_cast<int>(it - headers.begin()));
+    }
+    select_columns(columns);
+}
+
+std::vector<std::string> csv::CsvReader::selected_headers() const {
+    std::vector<std::string> names(out_cols);
+    for (int i = 0; i < col_num; i++) {
+        if (slots[i] >= 0) names[slots[i]] = headers[i];
+    }
+    return names;
+}
+
+void csv::CsvReader::add_filter(const csv::predicate &predicate) {
+    const auto it = std::find(headers.begin(), headers.end(), predicate.column);
+    if (it == headers.end()) {
+        throw std::invalid_argument("Unknown column: " + predicate.column);
+    }
+    const int col = static_cast<int>(it - headers.begin());
+
+    filters.emplace_back(predicate);
+    filters.back().next = filter_at[col];
+    filter_at[col] = static_cast<int>(filters.size() - 1);
+    filter_from = std::max(filter_from, col + 1);
+}
+
+void csv::CsvReader::clear_filters() {
+    filters.clear();
+    filter_at.assign(col_num, -1);
+    filter_from = 0;
+}
+
+uint64_t csv::CsvReader::count_range(const char* begin, const char* stop, csv::simd::newline_count& out) const {
+    const csv::simd::kernel& kernel = csv::simd::active();
+    const csv::simd::pattern pat = simd_pattern();
+    const size_t blocks = (stop - begin) / csv::simd::BLOCK;
+    uint64_t in_quote = kernel.count(begin, blocks, pat, 0, out);
+
+    const char* tail = begin + blocks * csv::simd::BLOCK;
+    if (tail < stop) {
+        // zero padding holds no newline and no quote
+        alignas(64) char block[csv::simd::BLOCK] = {};
+        std::memcpy(block, tail, stop - tail);
+        in_quote = kernel.count(block, 1, pat, in_quote, out);
+    }
+    return in_quote;
+}
+
+void csv::CsvReader::finish_count(csv::row_stats &stats, const char last, const uint64_t in_quote) const {
+    if (stats.bytes == 0) return;
+    const csv::simd::pattern pat = simd_pattern();
+    const bool ended = last == pat.new_line || (pat.lone_cr && last == '\r');
+    if (!ended) stats.lines++;
+    if (!ended || in_quote) stats.rows++;
+}
+
+csv::row_stats csv::CsvReader::count_rows() {
+    if (f_stream) {
+        return count_stream();
+    }
+    csv::simd::newline_count counts;
+    const uint64_t in_quote = count_range(data_start, end, counts);
+
+    csv::row_stats stats;
+    stats.rows = counts.rows;
+    stats.lines = counts.lines;
+    stats.bytes = end - data_start;
+    finish_count(stats, stats.bytes ? end[-1] : '\0', in_quote);
+    return stats;
+}
+
+csv::row_stats csv::CsvReader::count_stream() {
+    if (stream_consumed) {
+        throw std::runtime_error("Stream already consumed");
+    }
+    stream_consumed = true;
+
+    const csv::simd::kernel& kernel = csv::simd::active();
+    const csv::simd::pattern pat = simd_pattern();
+    csv::simd::newline_count counts;
+    csv::row_stats stats;
+    uint64_t in_quote = 0;
+    char last = '\0';
+    const char* ptr = data_start;
+
+    // full blocks per read, the < 64 byte remainder is kept for the next read
+    while (true) {
+        if (ptr < end) last = end[-1];
+        const bool eof = f_stream->eof();
+        const size_t blocks = (end - ptr) / csv::simd::BLOCK;
+        in_quote = kernel.count(ptr, blocks, pat, in_quote, counts);
+        ptr += blocks * csv::simd::BLOCK;
+        stats.bytes += blocks * csv::simd::BLOCK;
+
+        if (eof) {
+            if (ptr < end) {
+                alignas(64) char block[csv::simd::BLOCK] = {};
+                std::memcpy(block, ptr, end - ptr);
+                in_quote = kernel.count(block, 1, pat, in_quote, counts);
+                stats.bytes += end - ptr;
             }
+            break;
         }
-        callback(current_row.get());
+        f_stream->fill(ptr);
+        ptr = f_stream->data();
+        end = ptr + f_stream->size();
     }
+    data_start = end;
 
-    // // Stop prefetcher thread
-    // {
-    //     std::lock_guard lock(prefetch_mtx);
-    //     done = true;
-    // }
-    // prefetch_cv.notify_one();
-    // prefetcher.join();
+    stats.rows = counts.rows;
+    stats.lines = counts.lines;
+    finish_count(stats, last, in_quote);
+    return stats;
 }
 
-// Parse header row and return: (col_count, headers, pointer after header line)
-void csv::CsvReader::parse_header_row(const char* data) {
-    const char* ptr = data;
-    const char* field_start = data;
-    bool in_quote = false;
-    int header_row_idx = 0;
+csv::row_stats csv::CsvReader::count_rows_parallel(parallel_options options) const {
+    if (!f_map) {
+        throw std::runtime_error("count_rows_parallel requires a mapped file");
+    }
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    const size_t total = end - data_start;
+    size_t chunk_size = options.chunk_size;
+    if (chunk_size == 0) {
+        chunk_size = std::clamp<size_t>(total / (threads * 4) + 1, 1 << 20, PREFETCH_CHUNK);
+    }
+    // whole blocks per chunk: only the last chunk has a tail
+    chunk_size = (chunk_size + csv::simd::BLOCK - 1) / csv::simd::BLOCK * csv::simd::BLOCK;
+    const size_t chunk_count = total == 0 ? 0 : (total + chunk_size - 1) / chunk_size;
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, chunk_count)));
+
+    // one pass: every chunk is counted as if it started outside quotes. a chunk that really
+    // starts inside a quote sees every quote region inverted, so its rows are lines - rows
+    std::vector<csv::simd::newline_count> counts(chunk_count);
+    std::vector<uint64_t> parity(chunk_count);
+    std::atomic<size_t> next{0};
+    detail::run_workers(threads, [&](unsigned) {
+        for (size_t c; (c = next.fetch_add(1, std::memory_order_relaxed)) < chunk_count;) {
+            const char* b = data_start + c * chunk_size;
+            parity[c] = count_range(b, std::min(b + chunk_size, end), counts[c]);
+        }
+    });
+
+    csv::row_stats stats;
+    const bool lone_cr = simd_pattern().lone_cr;
+    uint64_t in_quote = 0;
+    for (size_t c = 0; c < chunk_count; c++) {
+        stats.rows += in_quote ? counts[c].lines - counts[c].rows : counts[c].rows;
+        stats.lines += counts[c].lines;
+        // "\r\n" cut by the split: both chunks counted a row end
+        const char* b = data_start + c * chunk_size;
+        if (lone_cr && c > 0 && b[-1] == '\r' && b[0] == '\n') {
+            stats.lines--;
+            if (!in_quote) stats.rows--;
+        }
+        in_quote ^= parity[c];
+    }
+    stats.bytes = total;
+    finish_count(stats, total ? end[-1] : '\0', in_quote);
+    return stats;
+}
+
+template <typename OnRow>
+void csv::CsvReader::scan_row_ends(const char* begin, const char* stop, const OnRow& on_row) const {
+    const csv::simd::kernel& kernel = csv::simd::active();
+    const csv::simd::pattern pat = simd_pattern();
+    csv::simd::block_masks masks[csv::simd::WINDOW_BLOCKS];
+    uint64_t in_quote = 0;
+
+    for (const char* ptr = begin; ptr < stop;) {
+        const size_t remain = stop - ptr;
+        size_t blocks = std::min(remain / csv::simd::BLOCK, csv::simd::WINDOW_BLOCKS);
+        size_t scanned = blocks * csv::simd::BLOCK;
+        if (blocks > 0) {
+            in_quote = kernel.scan(ptr, blocks, pat, in_quote, masks);
+        } else {
+            alignas(64) char tail[csv::simd::BLOCK] = {};
+            std::memcpy(tail, ptr, remain);
+            in_quote = kernel.scan(tail, 1, pat, in_quote, masks);
+            masks[0].newline &= (1ull << remain) - 1;
+            masks[0].cr &= (1ull << remain) - 1;
+            blocks = 1;
+            scanned = remain;
+        }
+        if (pat.crlf) {
+            csv::simd::resolve_crlf(masks, blocks, ptr > begin && ptr[-1] == '\r',
+                                    ptr + scanned < stop && ptr[scanned] == '\n', pat.lone_cr);
+        }
+        for (size_t b = 0; b < blocks; b++) {
+            for (uint64_t nl = masks[b].newline; nl != 0; nl &= nl - 1) {
+                on_row(ptr + b * csv::simd::BLOCK + __builtin_ctzll(nl) + 1);
+            }
+        }
+        ptr += scanned;
+    }
+}
+
+std::string csv::CsvReader::index_path() const {
+    return std::string(file_path) + ".idx";
+}
+
+csv::index_stamp csv::CsvReader::current_stamp() const {
+    csv::index_stamp stamp = csv::stamp_of(file_path);
+    stamp.new_line = format.new_line;
+    stamp.line_ending = static_cast<char>(format.line_ending);
+    stamp.quote = format.quote.value_or('\0');
+    stamp.has_quote = format.quote.has_value();
+    stamp.header_row = format.header_row;
+    return stamp;
+}
+
+bool csv::CsvReader::save_index() const {
+    try {
+        row_index->save(index_path(), current_stamp());
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+void csv::CsvReader::use_index(const size_t stride) {
+    if (!f_map) {
+        throw std::runtime_error("Row index requires a mapped file");
+    }
+    index_stride = stride;
+    auto index = std::make_unique<csv::RowIndex>(stride);
+    if (index->load(index_path(), current_stamp())) {
+        row_index = std::move(index);
+    } else {
+        row_index.reset();
+    }
+}
 
+void csv::CsvReader::build_index(const size_t stride) {
+    if (!f_map) {
+        throw std::runtime_error("Row index requires a mapped file");
+    }
+    index_stride = stride;
+    auto index = std::make_unique<csv::RowIndex>(stride);
+    const char* base = f_map->data();
+    uint64_t rows = 0;
+    const char* row_begin = data_start;
+    index->add(data_start - base);
+    scan_row_ends(data_start, end, [&](const char* next) {
+        row_begin = next;
+        if (++rows % stride == 0) index->add(next - base);
+    });
+    // a last row without newline
+    if (row_begin < end) {
+        rows++;
+    }
+    index->finish(rows);
+    row_index = std::move(index);
+    save_index();
+}
+
+csv::simd::pattern csv::CsvReader::simd_pattern() const {
+    csv::simd::pattern pat;
+    pat.delimiter = format.delimiter;
+    pat.new_line = format.new_line;
+    pat.quote = format.quote.value_or('\0');
+    pat.has_quote = format.quote.has_value();
+    if (format.line_ending != csv::eol::single) {
+        pat.new_line = '\n';
+        pat.crlf = true;
+        pat.lone_cr = format.line_ending == csv::eol::any;
+    }
+    return pat;
+}
 
-    while (ptr < end) {
+uint32_t csv::CsvReader::quote_parity(const char* begin, const char* stop) const {
+    const size_t blocks = (stop - begin) / csv::simd::BLOCK;
+    const char quote = format.quote.value_or('\0');
+    uint32_t parity = static_cast<uint32_t>(csv::simd::active().parity(begin, blocks, quote));
+
+    for (const char* ptr = begin + blocks * csv::simd::BLOCK; ptr < stop; ptr++) {
+        parity ^= (*ptr == quote);
+    }
+    return parity & 1;
+}
+
+const char* csv::CsvReader::next_row_start(const char* pos, uint32_t in_quote, const char* limit) const {
+    if (limit == nullptr) limit = end;
+    const char* ptr = pos;
+    while (ptr < limit) {
         const char c = *ptr;
         if (format.quote.has_value() && c == format.quote.value()) {
-            in_quote = !in_quote;
-        } else if (!in_quote) {
-            if (c == format.delimiter || c == format.new_line) {
-                if (header_row_idx == format.header_row) {
-                    std::string header {trim_quotes(std::string_view(field_start, ptr - field_start), format)};
-                    headers.push_back(header);
-                }
-                field_start = ptr + 1;
-                if (c == format.new_line) {
-                    if (header_row_idx == format.header_row) {
-                        this->col_num = static_cast<int>(headers.size());
-                        this->data_start = ptr + 1;
-                        return;
-                    }
-                    header_row_idx++;
-                }
-            }
+            in_quote ^= 1;
+        } else if (!in_quote && detail::row_ends_at(format, ptr, end)) {
+            return ptr + 1;
         }
         ptr++;
     }
+    return limit;
+}
+
+const char* csv::CsvReader::sample_start(const char* pos, const size_t window) const {
+    // a wrong quote guess on a file with few quotes would otherwise scan to the end
+    const char* limit = static_cast<size_t>(end - pos) > window ? pos + window : end;
+    const char* outside = next_row_start(pos, 0, limit);
+    if (!format.quote.has_value()) {
+        return outside == limit ? end : outside;
+    }
+    const char* inside = next_row_start(pos, 1, limit);
+    if (inside == limit) return outside == limit ? end : outside;
+    if (outside == limit || inside == outside) return inside;
+    return consistent_rows(inside, limit) > consistent_rows(outside, limit) ? inside : outside;
+}
+
+size_t csv::CsvReader::consistent_rows(const char* row, const char* limit) const {
+    size_t rows = 0;
+    while (rows < INFER_CHECK_ROWS && row != nullptr && row < limit) {
+        int fields = 0;
+        const char* next = detail::split_row(row, limit, format, [&](std::string_view) { fields++; });
+        // a row cut by the window is not evidence, one cut by the end of the file is
+        if (fields != col_num || (next == nullptr && limit != end)) break;
+        row = next;
+        rows++;
+    }
+    return rows;
+}
 
-    // Handle last field if no trailing newline
-    if (field_start < end) {
-        std::string header {trim_quotes(std::string_view(field_start, end - field_start), format)};
-        headers.push_back(header);
+// Parse header row and return: (col_count, headers, pointer after header line)
+bool csv::CsvReader::parse_header_row(const char* data) {
+    const char* row = data;
+    for (int row_idx = 0;; row_idx++) {
+        const bool is_header = row_idx == format.header_row;
+        const char* next = detail::split_row(row, end, format, [&](const std::string_view field) {
+            if (is_header) headers.emplace_back(field);
+        });
+        if (next == nullptr) {
+            // not terminated before end, keep what was found
+            this->col_num = static_cast<int>(headers.size());
+            this->data_start = end;
+            return false;
+        }
+        if (is_header) {
+            this->col_num = static_cast<int>(headers.size());
+            this->data_start = next;
+            return true;
+        }
+        row = next;
     }
-    this->col_num = static_cast<int>(headers.size());
-    this->data_start = end;
 }
 
-#endif //SIMDCSV_CSV_READER_H
\ No newline at end of file
+#endif //SIMDCSV_CSV_READER_H
@@ -0,0 +1,319 @@
+//
+// Created by lehoai on 2/21/26.
+//
+
+#ifndef SIMDCSV_DATASET_H
+#define SIMDCSV_DATASET_H
+
+// many files with one header, parsed on one fixed pool
+// 1. files bigger than a chunk are split, a parity pass gives the exact quote state at every split
+// 2. smaller files are batched into tasks of about a chunk
+// 3. tasks are dealt largest first over per-worker deques, an idle worker steals from the others
+//
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csv_reader.h"
+
+namespace csv {
+
+    // options for Dataset::parse
+    struct dataset_options {
+        unsigned threads = 0;     // 0 = std::thread::hardware_concurrency()
+        size_t chunk_size = 0;    // bytes per task, 0 = auto; larger files are split, smaller ones batched
+    };
+
+    namespace detail {
+        // '*' any run, '?' any one char
+        inline bool wildcard_match(const std::string_view pattern, const std::string_view name) {
+            size_t p = 0, n = 0;
+            size_t star = std::string_view::npos, resume = 0;
+            while (n < name.size()) {
+                if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                    p++;
+                    n++;
+                } else if (p < pattern.size() && pattern[p] == '*') {
+                    star = p++;
+                    resume = n;
+                } else if (star != std::string_view::npos) {
+                    p = star + 1;
+                    n = ++resume;
+                } else {
+                    return false;
+                }
+            }
+            while (p < pattern.size() && pattern[p] == '*') p++;
+            return p == pattern.size();
+        }
+
+        // fixed task set dealt over per-worker deques: a worker pops the front of its own,
+        // then steals from the back of the others
+        class steal_queue {
+        private:
+            struct lane {
+                std::mutex mtx;
+                std::deque<size_t> tasks;
+            };
+            std::unique_ptr<lane[]> _lanes;
+            unsigned _workers;
+        public:
+            // order: tasks in the order they should start, dealt round robin
+            steal_queue(const unsigned workers, const std::vector<size_t>& order)
+                : _lanes(std::make_unique<lane[]>(workers)), _workers(workers) {
+                for (size_t i = 0; i < order.size(); i++) {
+                    _lanes[i % workers].tasks.push_back(order[i]);
+                }
+            }
+
+            bool next(const unsigned worker, size_t& task) {
+                {
+                    lane& own = _lanes[worker];
+                    std::lock_guard lock(own.mtx);
+                    if (!own.tasks.empty()) {
+                        task = own.tasks.front();
+                        own.tasks.pop_front();
+                        return true;
+                    }
+                }
+                for (unsigned i = 1; i < _workers; i++) {
+                    lane& victim = _lanes[(worker + i) % _workers];
+                    std::lock_guard lock(victim.mtx);
+                    if (!victim.tasks.empty()) {
+                        task = victim.tasks.back();
+                        victim.tasks.pop_back();
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+    }
+
+    class Dataset {
+    private:
+        struct file_entry {
+            std::string path;
+            uint64_t bytes;
+        };
+        csv::format format;
+        std::vector<file_entry> entries;
+        std::vector<std::string> headers;
+        std::vector<std::string> selected;
+        std::vector<csv::predicate> filters;
+
+        // open every file once: sizes and header check
+        inline void load(std::vector<std::string> paths);
+        // reader for file with the selection and filters applied
+        inline std::unique_ptr<csv::CsvReader> open(size_t file) const;
+    public:
+        // every file must have the same header as the first one
+        Dataset(std::vector<std::string> paths, csv::format format);
+        // files of directory whose name matches pattern ('*', '?'), in name order
+        Dataset(const std::string& directory, const std::string& pattern, csv::format format);
+
+        [[nodiscard]] size_t files() const { return entries.size(); }
+        [[nodiscard]] const std::string& path(const size_t file) const { return entries[file].path; }
+        [[nodiscard]] uint64_t bytes() const;
+        [[nodiscard]] const std::vector<std::string>& getHeaders() const { return headers; }
+
+        // same as CsvReader::select_columns / add_filter, applied to every file
+        inline void select_columns(const std::vector<std::string>& names);
+        inline void add_filter(const csv::predicate& predicate);
+
+        // callback(worker, file, row) is called concurrently from all workers, file indexes path()
+        // rows of one task arrive in file order, tasks in no particular order
+        template <typename RowCallback>
+        void parse(const RowCallback& callback, dataset_options options = {}) const;
+    };
+}
+
+inline csv::Dataset::Dataset(std::vector<std::string> paths, const csv::format format) {
+    this->format = format;
+    load(std::move(paths));
+}
+
+inline csv::Dataset::Dataset(const std::string& directory, const std::string& pattern, const csv::format format) {
+    this->format = format;
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && detail::wildcard_match(pattern, entry.path().filename().string())) {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    load(std::move(paths));
+}
+
+void csv::Dataset::load(std::vector<std::string> paths) {
+    entries.reserve(paths.size());
+    for (auto& path : paths) {
+        entries.push_back({std::move(path), 0});
+        file_entry& entry = entries.back();
+        csv::CsvReader reader(entry.path.c_str(), format);
+        entry.bytes = reader.end - reader.data_start;
+        if (entries.size() == 1) {
+            headers = reader.getHeaders();
+        } else if (reader.getHeaders() != headers) {
+            throw std::invalid_argument("Header mismatch: " + entry.path);
+        }
+    }
+}
+
+std::unique_ptr<csv::CsvReader> csv::Dataset::open(const size_t file) const {
+    auto reader = std::make_unique<csv::CsvReader>(entries[file].path.c_str(), format);
+    if (!selected.empty()) reader->select_columns(selected);
+    for (const auto& predicate : filters) reader->add_filter(predicate);
+    return reader;
+}
+
+uint64_t csv::Dataset::bytes() const {
+    uint64_t total = 0;
+    for (const auto& entry : entries) total += entry.bytes;
+    return total;
+}
+
+void csv::Dataset::select_columns(const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        if (std::find(headers.begin(), headers.end(), name) == headers.end()) {
+            throw std::invalid_argument("Unknown column: " + name);
+        }
+    }
+    selected = names;
+}
+
+void csv::Dataset::add_filter(const csv::predicate& predicate) {
+    if (std::find(headers.begin(), headers.end(), predicate.column) == headers.end()) {
+        throw std::invalid_argument("Unknown column: " + predicate.column);
+    }
+    filters.push_back(predicate);
+}
+
+template <typename RowCallback>
+void csv::Dataset::parse(const RowCallback& callback, dataset_options options) const {
+    if (entries.empty()) return;
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    size_t chunk_size = options.chunk_size;
+    if (chunk_size == 0) {
+        // same sizing as CsvReader::parse_parallel, over the whole dataset
+        chunk_size = bytes() / (threads * 4) + 1;
+        chunk_size = std::clamp<size_t>(chunk_size, 1 << 20, PREFETCH_CHUNK);
+    }
+
+    // large files stay open for their chunks
+    struct split_file {
+        size_t file;
+        std::unique_ptr<csv::CsvReader> reader;
+        size_t chunks;
+        std::vector<uint32_t> quote;   // quote state at each chunk start
+    };
+    // a run of small files (split = NONE) or one chunk of a split file
+    constexpr size_t NONE = static_cast<size_t>(-1);
+    struct task {
+        size_t first;
+        size_t count;
+        size_t split;
+        size_t chunk;
+        uint64_t bytes;
+    };
+
+    std::vector<split_file> splits;
+    std::vector<task> tasks;
+    task batch{0, 0, NONE, 0, 0};
+    for (size_t f = 0; f < entries.size(); f++) {
+        const uint64_t size = entries[f].bytes;
+        if (size > chunk_size) {
+            // batches are runs of consecutive files
+            if (batch.count > 0) {
+                tasks.push_back(batch);
+                batch = {0, 0, NONE, 0, 0};
+            }
+            const size_t chunks = (size + chunk_size - 1) / chunk_size;
+            for (size_t c = 0; c < chunks; c++) {
+                tasks.push_back({f, 1, splits.size(), c, std::min<uint64_t>(chunk_size, size - c * chunk_size)});
+            }
+            splits.push_back({f, open(f), chunks, std::vector<uint32_t>(chunks, 0)});
+            continue;
+        }
+        if (batch.count == 0) batch.first = f;
+        batch.count++;
+        batch.bytes += size;
+        if (batch.bytes >= chunk_size) {
+            tasks.push_back(batch);
+            batch = {0, 0, NONE, 0, 0};
+        }
+    }
+    if (batch.count > 0) tasks.push_back(batch);
+    threads = static_cast<unsigned>(std::min<size_t>(threads, tasks.size()));
+
+    // PASS 1: quote parity of every chunk of every split file
+    if (format.quote.has_value()) {
+        std::vector<std::pair<size_t, size_t>> parity_tasks;
+        for (size_t s = 0; s < splits.size(); s++) {
+            for (size_t c = 1; c < splits[s].chunks; c++) parity_tasks.emplace_back(s, c - 1);
+        }
+        std::atomic<size_t> next{0};
+        detail::run_workers(threads, [&](unsigned) {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < parity_tasks.size();) {
+                split_file& split = splits[parity_tasks[i].first];
+                const size_t c = parity_tasks[i].second;
+                const char* b = split.reader->data_start + c * chunk_size;
+                split.quote[c + 1] = split.reader->quote_parity(b, std::min(b + chunk_size, split.reader->end));
+            }
+        });
+        for (auto& split : splits) {
+            for (size_t c = 1; c < split.chunks; c++) split.quote[c] ^= split.quote[c - 1];
+        }
+    }
+
+    // PASS 2: largest tasks first, so the small ones fill the gaps at the end
+    std::vector<size_t> order(tasks.size());
+    for (size_t t = 0; t < order.size(); t++) order[t] = t;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](const size_t a, const size_t b) { return tasks[a].bytes > tasks[b].bytes; });
+    detail::steal_queue queue(threads, order);
+    // a file gone since the dataset was built or a throwing callback: the others stop, the
+    // exception reaches the caller through run_workers
+    std::atomic<bool> failed{false};
+
+    detail::run_workers(threads, [&](const unsigned worker) {
+        const auto no_progress = [](const char*) {};
+        const auto deliver = [&](const csv::CsvReader& reader, const size_t file, const char* begin, const char* stop) {
+            if (begin >= stop) return;
+            auto current_row = std::make_unique<std::string_view[]>(reader.out_cols);
+            auto on_row = [&](const std::string_view* row) { callback(worker, file, row); };
+            detail::row_sink<decltype(on_row)> out{current_row.get(), on_row};
+            reader.parse_rows(begin, stop, true, out, no_progress);
+        };
+
+        for (size_t t; !failed.load(std::memory_order_relaxed) && queue.next(worker, t);) {
+            const task& job = tasks[t];
+            if (job.split == NONE) {
+                for (size_t f = job.first; f < job.first + job.count; f++) {
+                    const auto reader = open(f);
+                    deliver(*reader, f, reader->data_start, reader->end);
+                }
+                continue;
+            }
+            // chunk c owns the rows starting in [row_start(c), row_start(c + 1))
+            const split_file& split = splits[job.split];
+            const csv::CsvReader& reader = *split.reader;
+            auto row_start = [&](const size_t c) -> const char* {
+                if (c == 0) return reader.data_start;
+                if (c >= split.chunks) return reader.end;
+                return reader.next_row_start(reader.data_start + c * chunk_size, split.quote[c]);
+            };
+            deliver(reader, split.file, row_start(job.chunk), row_start(job.chunk + 1));
+        }
+    }, &failed);
+}
+
+#endif //SIMDCSV_DATASET_H
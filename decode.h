@@ -0,0 +1,315 @@
+//
+// Created by lehoai on 2/11/26.
+//
+
+#ifndef SIMDCSV_DECODE_H
+#define SIMDCSV_DECODE_H
+
+// typed column decoding
+// a schema names the columns to read and their type, every column batch is decoded column-at-a-time
+// into typed arrays with an Arrow validity bitmap (bit = 1 -> value present)
+// integers use SWAR: 8 digits are validated and converted with a few 64-bit multiplies
+//
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "columnar.h"
+#include "number.h"
+
+namespace csv {
+    // date32: days since 1970-01-01 (Arrow date32) from ISO "YYYY-MM-DD", stored in int32_values
+    enum class column_type { string, int32, int64, float64, boolean, date32 };
+
+    struct column_spec {
+        std::string name;
+        column_type type = column_type::string;
+    };
+
+    using schema = std::vector<column_spec>;
+
+    // ==================== SWAR DIGITS ====================
+
+    // n (1..8) ascii chars in the low bytes of w -> value, false if any is not a digit
+    inline bool parse_digits8(uint64_t w, const size_t n, uint32_t& out) {
+        const uint64_t keep = n == 8 ? ~0ull : (1ull << (8 * n)) - 1;
+        w &= keep;
+        // every byte in 0x30..0x39: high nibble is 3 and adding 6 does not reach the high nibble
+        if ((w & 0xF0F0F0F0F0F0F0F0ull) != (0x3030303030303030ull & keep)
+            || ((w + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull & keep) != (0x3030303030303030ull & keep)) {
+            return false;
+        }
+        uint64_t d = w - (0x3030303030303030ull & keep);
+        // leading zero digits: move the number to the high bytes
+        if (n < 8) d <<= 8 * (8 - n);
+
+        d = (d * 10) + (d >> 8);
+        d = (((d & 0x000000FF000000FFull) * 0x000F424000000064ull)
+             + (((d >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+        out = static_cast<uint32_t>(d);
+        return true;
+    }
+
+    // p must stay readable for n + 8 bytes
+    inline bool parse_int64_padded(const char* p, size_t n, int64_t& out) {
+        bool negative = false;
+        if (n > 0 && (p[0] == '-' || p[0] == '+')) {
+            negative = p[0] == '-';
+            p++;
+            n--;
+        }
+        if (n == 0 || n > 19) {
+            return false;
+        }
+
+        // first chunk takes the remainder so every following chunk is 8 digits
+        size_t len = n % 8 == 0 ? 8 : n % 8;
+        uint64_t value = 0;
+        for (size_t pos = 0; pos < n; pos += len, len = 8) {
+            uint64_t w;
+            std::memcpy(&w, p + pos, 8);
+            uint32_t chunk;
+            if (!parse_digits8(w, len, chunk)) {
+                return false;
+            }
+            // 19 digits: at most 11 before the last chunk, * 1e8 still fits uint64
+            value = value * (len == 8 ? 100000000ull : 1) + chunk;
+        }
+
+        if (value > static_cast<uint64_t>(INT64_MAX) + negative) {
+            return false;
+        }
+        out = negative ? static_cast<int64_t>(0 - value) : static_cast<int64_t>(value);
+        return true;
+    }
+
+    inline bool parse_int64(const std::string_view sv, int64_t& out) {
+        if (sv.size() > 20) return false;
+        char buf[32] = {};
+        std::memcpy(buf, sv.data(), sv.size());
+        return parse_int64_padded(buf, sv.size(), out);
+    }
+
+    inline bool parse_bool(const std::string_view sv, bool& out) {
+        auto lower = [](const char c) { return static_cast<char>(c | 0x20); };
+        if (sv.size() == 1) {
+            const char c = lower(sv[0]);
+            if (c == '1' || c == 't') { out = true; return true; }
+            if (c == '0' || c == 'f') { out = false; return true; }
+            return false;
+        }
+        if (sv.size() == 4 && lower(sv[0]) == 't' && lower(sv[1]) == 'r' && lower(sv[2]) == 'u' && lower(sv[3]) == 'e') {
+            out = true;
+            return true;
+        }
+        if (sv.size() == 5 && lower(sv[0]) == 'f' && lower(sv[1]) == 'a' && lower(sv[2]) == 'l'
+            && lower(sv[3]) == 's' && lower(sv[4]) == 'e') {
+            out = false;
+            return true;
+        }
+        return false;
+    }
+
+    inline bool parse_double(const std::string_view sv, double& out) {
+        return parse_float(sv, out) == parse_status::ok;
+    }
+
+    // "YYYY-MM-DD" -> days since 1970-01-01, the day must exist in that month
+    inline bool parse_date(const std::string_view sv, int32_t& out) {
+        if (sv.size() != 10 || sv[4] != '-' || sv[7] != '-') {
+            return false;
+        }
+        uint64_t w;
+        std::memcpy(&w, sv.data(), 8);
+        uint32_t year, month, day;
+        // "YYYY-MM-" -> year digits, then month and day through the same SWAR check
+        if (!parse_digits8(w, 4, year) || !parse_digits8(w >> 40, 2, month)) {
+            return false;
+        }
+        std::memcpy(&w, sv.data() + 2, 8);
+        if (!parse_digits8(w >> 48, 2, day) || month < 1 || month > 12 || day < 1) {
+            return false;
+        }
+        const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        static constexpr uint8_t DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (day > static_cast<uint32_t>(DAYS[month - 1] + (month == 2 && leap))) {
+            return false;
+        }
+        // days from civil (proleptic Gregorian), eras of 400 years
+        const int y = static_cast<int>(year) - (month <= 2);
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const int yoe = y - era * 400;
+        const int doy = (153 * static_cast<int>(month > 2 ? month - 3 : month + 9) + 2) / 5 + static_cast<int>(day) - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        out = era * 146097 + doe - 719468;
+        return true;
+    }
+
+    // ==================== TYPED BATCH ====================
+
+    struct TypedColumn {
+        std::string name;
+        column_type type = column_type::string;
+        std::vector<uint8_t> validity;   // Arrow bitmap, LSB first
+        size_t null_count = 0;           // empty + invalid
+        size_t invalid_count = 0;        // non-empty fields that did not decode
+        std::vector<int32_t> int32_values;   // int32 and date32
+        std::vector<int64_t> int64_values;
+        std::vector<double> float64_values;
+        std::vector<uint8_t> bool_values;  // Arrow bitmap, LSB first
+
+        [[nodiscard]] bool valid(const size_t row) const { return (validity[row >> 3] >> (row & 7)) & 1; }
+        [[nodiscard]] bool bool_value(const size_t row) const { return (bool_values[row >> 3] >> (row & 7)) & 1; }
+    };
+
+    class TypedBatch {
+    private:
+        std::vector<TypedColumn> _columns;
+        const ColumnBatch* _source = nullptr;
+        size_t _rows = 0;
+    public:
+        explicit TypedBatch(const csv::schema& schema);
+
+        [[nodiscard]] size_t rows() const { return _rows; }
+        [[nodiscard]] size_t columns() const { return _columns.size(); }
+        [[nodiscard]] const TypedColumn& column(size_t column) const { return _columns[column]; }
+        // string columns stay views into the source batch
+        [[nodiscard]] std::string_view string(size_t column, size_t row) const { return _source->value(column, row); }
+
+        inline void decode(const ColumnBatch& batch);
+    };
+
+    namespace detail {
+        // decode every view of one column with parse(view, value&) -> bool
+        template <typename T, typename Parse>
+        inline void decode_column(const arrow_view* views, const ColumnBatch& batch, const size_t column,
+                                  const size_t rows, T* values, TypedColumn& out, const Parse& parse) {
+            uint8_t* validity = out.validity.data();
+            size_t invalid = 0;
+            size_t nulls = 0;
+            for (size_t r = 0; r < rows; r++) {
+                const arrow_view& view = views[r];
+                T value{};
+                bool ok = false;
+                if (view.size != 0) {
+                    ok = parse(view, batch, column, r, value);
+                    invalid += !ok;
+                }
+                values[r] = value;
+                validity[r >> 3] |= static_cast<uint8_t>(ok) << (r & 7);
+                nulls += !ok;
+            }
+            out.invalid_count = invalid;
+            out.null_count = nulls;
+        }
+
+        // inline views (<= 12 bytes) are parsed straight from the 16-byte view, no pointer chase
+        // up to 8 unsigned digits take a single SWAR step on the view bytes
+        inline bool view_int64(const arrow_view& view, const ColumnBatch& batch, const size_t column,
+                               const size_t row, int64_t& value) {
+            if (view.size <= 12) {
+                const char* p = reinterpret_cast<const char*>(&view) + 4;
+                if (view.size <= 8 && p[0] != '-' && p[0] != '+') {
+                    uint64_t w;
+                    std::memcpy(&w, p, 8);
+                    uint32_t digits;
+                    if (!parse_digits8(w, view.size, digits)) {
+                        return false;
+                    }
+                    value = digits;
+                    return true;
+                }
+                char buf[24] = {};
+                std::memcpy(buf, p, 12);
+                return parse_int64_padded(buf, view.size, value);
+            }
+            return parse_int64(batch.value(column, row), value);
+        }
+    }
+}
+
+inline csv::TypedBatch::TypedBatch(const csv::schema &schema) {
+    _columns.resize(schema.size());
+    for (size_t c = 0; c < schema.size(); c++) {
+        _columns[c].name = schema[c].name;
+        _columns[c].type = schema[c].type;
+    }
+}
+
+void csv::TypedBatch::decode(const ColumnBatch &batch) {
+    _source = &batch;
+    _rows = batch.rows();
+
+    for (size_t c = 0; c < _columns.size(); c++) {
+        TypedColumn& out = _columns[c];
+        out.validity.assign((_rows + 7) / 8, 0);
+        out.null_count = 0;
+        out.invalid_count = 0;
+        const arrow_view* views = batch.views(c);
+
+        switch (out.type) {
+            case column_type::int32:
+                out.int32_values.resize(_rows);
+                detail::decode_column(views, batch, c, _rows, out.int32_values.data(), out,
+                    [](const arrow_view& view, const ColumnBatch& b, size_t col, size_t row, int32_t& value) {
+                        int64_t wide;
+                        if (!detail::view_int64(view, b, col, row, wide) || wide < INT32_MIN || wide > INT32_MAX) {
+                            return false;
+                        }
+                        value = static_cast<int32_t>(wide);
+                        return true;
+                    });
+                break;
+            case column_type::int64:
+                out.int64_values.resize(_rows);
+                detail::decode_column(views, batch, c, _rows, out.int64_values.data(), out,
+                    [](const arrow_view& view, const ColumnBatch& b, size_t col, size_t row, int64_t& value) {
+                        return detail::view_int64(view, b, col, row, value);
+                    });
+                break;
+            case column_type::float64:
+                out.float64_values.resize(_rows);
+                detail::decode_column(views, batch, c, _rows, out.float64_values.data(), out,
+                    [](const arrow_view&, const ColumnBatch& b, size_t col, size_t row, double& value) {
+                        return parse_double(b.value(col, row), value);
+                    });
+                break;
+            case column_type::boolean: {
+                std::vector<uint8_t> values(_rows);
+                detail::decode_column(views, batch, c, _rows, values.data(), out,
+                    [](const arrow_view&, const ColumnBatch& b, size_t col, size_t row, uint8_t& value) {
+                        bool flag = false;
+                        const bool ok = parse_bool(b.value(col, row), flag);
+                        value = flag;
+                        return ok;
+                    });
+                out.bool_values.assign((_rows + 7) / 8, 0);
+                for (size_t r = 0; r < _rows; r++) {
+                    out.bool_values[r >> 3] |= values[r] << (r & 7);
+                }
+                break;
+            }
+            case column_type::date32:
+                out.int32_values.resize(_rows);
+                detail::decode_column(views, batch, c, _rows, out.int32_values.data(), out,
+                    [](const arrow_view& view, const ColumnBatch&, size_t, size_t, int32_t& value) {
+                        // 10 bytes: always inlined in the view
+                        if (view.size != 10) return false;
+                        return parse_date(std::string_view(reinterpret_cast<const char*>(&view) + 4, 10), value);
+                    });
+                break;
+            case column_type::string:
+                // every non-empty field is valid
+                for (size_t r = 0; r < _rows; r++) {
+                    const bool ok = views[r].size != 0;
+                    out.validity[r >> 3] |= static_cast<uint8_t>(ok) << (r & 7);
+                    out.null_count += !ok;
+                }
+                break;
+        }
+    }
+}
+
+#endif //SIMDCSV_DECODE_H
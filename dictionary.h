@@ -0,0 +1,162 @@
+//
+// Created by lehoai on 2/26/26.
+//
+
+#ifndef SIMDCSV_DICTIONARY_H
+#define SIMDCSV_DICTIONARY_H
+
+// dictionary encoding of low-cardinality columns: distinct field bytes -> dense uint32 codes
+// open addressing with linear probing, at most half full; a slot holds the first 16 key bytes
+// zero padded, so a key of up to 16 bytes is compared with one 16-byte SIMD compare and no
+// pointer chase. longer keys compare the rest against the stored copy
+// values are copied once into an arena and stay valid for the dictionary's lifetime
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "simd.h"
+#include "unescape.h"
+
+namespace csv {
+
+    class Dictionary {
+    private:
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+        static constexpr size_t INLINE = 16;
+
+        struct slot {
+            char head[INLINE];   // first key bytes, zero padded
+            uint32_t size;
+            uint32_t code;       // EMPTY = free slot
+        };
+
+        std::vector<slot> _slots;
+        size_t _mask = 0;
+        std::vector<std::string_view> _values;   // by code, views into _bytes
+        detail::arena _bytes;
+
+        static inline uint64_t hash(const char* head, const char* key, size_t size);
+        static inline bool same_head(const char* a, const char* b);
+        inline void grow();
+        // slot holding key, or the free slot where it belongs
+        inline size_t probe(const char* head, std::string_view key, uint64_t h) const;
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        // capacity: distinct values expected, the table grows past it
+        explicit Dictionary(size_t capacity = 64);
+
+        // code of key, a new key gets the next code
+        inline uint32_t encode(std::string_view key);
+        // code of key or NONE
+        [[nodiscard]] inline uint32_t find(std::string_view key) const;
+
+        [[nodiscard]] size_t size() const { return _values.size(); }
+        [[nodiscard]] std::string_view value(const uint32_t code) const { return _values[code]; }
+        // values in code order
+        [[nodiscard]] const std::vector<std::string_view>& values() const { return _values; }
+        inline void clear();
+    };
+}
+
+inline csv::Dictionary::Dictionary(const size_t capacity) {
+    size_t slots = 16;
+    while (slots < capacity * 2) slots *= 2;
+    _slots.assign(slots, slot{{}, 0, EMPTY});
+    _mask = slots - 1;
+}
+
+uint64_t csv::Dictionary::hash(const char* head, const char* key, const size_t size) {
+    constexpr uint64_t K1 = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t K2 = 0xBF58476D1CE4E5B9ull;
+    uint64_t a, b;
+    std::memcpy(&a, head, 8);
+    std::memcpy(&b, head + 8, 8);
+    uint64_t h = (a ^ size) * K1 ^ b * K2;
+    // long keys: every further 8 bytes, the last word overlapping
+    for (size_t i = INLINE; i < size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, key + std::min(i, size - 8), 8);
+        h = (h ^ w) * K1;
+    }
+    // the low bits pick the slot: fold the high bits, which saw every key byte, into them
+    h ^= h >> 32;
+    h *= K2;
+    return h ^ h >> 29;
+}
+
+bool csv::Dictionary::same_head(const char* a, const char* b) {
+#if SIMDCSV_X86
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xFFFF;
+#else
+    return std::memcmp(a, b, INLINE) == 0;
+#endif
+}
+
+size_t csv::Dictionary::probe(const char* head, const std::string_view key, const uint64_t h) const {
+    for (size_t i = h & _mask;; i = (i + 1) & _mask) {
+        const slot& s = _slots[i];
+        if (s.code == EMPTY) return i;
+        if (s.size == key.size() && same_head(s.head, head)
+            && (key.size() <= INLINE
+                || std::memcmp(_values[s.code].data() + INLINE, key.data() + INLINE, key.size() - INLINE) == 0)) {
+            return i;
+        }
+    }
+}
+
+uint32_t csv::Dictionary::encode(const std::string_view key) {
+    char head[INLINE] = {};
+    std::memcpy(head, key.data(), std::min(key.size(), INLINE));
+    const uint64_t h = hash(head, key.data(), key.size());
+    size_t i = probe(head, key, h);
+    if (_slots[i].code != EMPTY) {
+        return _slots[i].code;
+    }
+
+    if ((_values.size() + 1) * 2 > _slots.size()) {
+        grow();
+        i = probe(head, key, h);
+    }
+    const auto code = static_cast<uint32_t>(_values.size());
+    char* copy = _bytes.alloc(key.size());
+    std::memcpy(copy, key.data(), key.size());
+    _values.emplace_back(copy, key.size());
+    slot& s = _slots[i];
+    std::memcpy(s.head, head, INLINE);
+    s.size = static_cast<uint32_t>(key.size());
+    s.code = code;
+    return code;
+}
+
+uint32_t csv::Dictionary::find(const std::string_view key) const {
+    char head[INLINE] = {};
+    std::memcpy(head, key.data(), std::min(key.size(), INLINE));
+    return _slots[probe(head, key, hash(head, key.data(), key.size()))].code;
+}
+
+void csv::Dictionary::grow() {
+    std::vector<slot> old(_slots.size() * 2, slot{{}, 0, EMPTY});
+    old.swap(_slots);
+    _mask = _slots.size() - 1;
+    for (const slot& s : old) {
+        if (s.code == EMPTY) continue;
+        const std::string_view key = _values[s.code];
+        size_t i = hash(s.head, key.data(), key.size()) & _mask;
+        while (_slots[i].code != EMPTY) i = (i + 1) & _mask;
+        _slots[i] = s;
+    }
+}
+
+void csv::Dictionary::clear() {
+    for (slot& s : _slots) s.code = EMPTY;
+    _values.clear();
+    _bytes.reset();
+}
+
+#endif //SIMDCSV_DICTIONARY_H
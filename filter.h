@@ -0,0 +1,103 @@
+//
+// Created by lehoai on 2/13/26.
+//
+
+#ifndef SIMDCSV_FILTER_H
+#define SIMDCSV_FILTER_H
+
+// row predicates, evaluated by the parser as soon as the field is found
+// a failing row is dropped on the spot: the rest of it is skipped like an unselected tail
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "simd.h"
+#include "number.h"
+
+namespace csv {
+
+    struct predicate {
+        enum class kind { equals, prefix, range };
+
+        std::string column;
+        kind op = kind::equals;
+        std::string value;   // equals / prefix
+        double min = -std::numeric_limits<double>::infinity();
+        double max = std::numeric_limits<double>::infinity();
+
+        static predicate equals(std::string column, std::string value) {
+            return {std::move(column), kind::equals, std::move(value)};
+        }
+
+        static predicate prefix(std::string column, std::string value) {
+            return {std::move(column), kind::prefix, std::move(value)};
+        }
+
+        // min <= value <= max, fields that are not numbers fail
+        static predicate range(std::string column, double min, double max) {
+            return {std::move(column), kind::range, {}, min, max};
+        }
+
+        static predicate at_least(std::string column, double min) {
+            return range(std::move(column), min, std::numeric_limits<double>::infinity());
+        }
+
+        static predicate at_most(std::string column, double max) {
+            return range(std::move(column), -std::numeric_limits<double>::infinity(), max);
+        }
+    };
+
+    namespace detail {
+        // one predicate bound to its column, filters on the same column are chained through next
+        struct row_filter {
+            predicate::kind op;
+            std::string value;
+            alignas(16) char padded[16];   // value zero padded for the 16-byte compare
+            double min;
+            double max;
+            int next = -1;
+
+            explicit row_filter(const predicate& p) : op(p.op), value(p.value), min(p.min), max(p.max) {
+                std::memset(padded, 0, sizeof(padded));
+                std::memcpy(padded, value.data(), std::min<size_t>(value.size(), sizeof(padded)));
+            }
+
+            // first n bytes of field equal the value, n <= field size
+            // field may be null for an empty value (padded missing field)
+            [[nodiscard]] bool same_bytes(const char* field, const size_t n) const {
+                if (n == 0) return true;
+#if SIMDCSV_X86
+                // one unaligned 16-byte load when it can not cross into the next page
+                if (n <= 16 && field != nullptr && (reinterpret_cast<uintptr_t>(field) & 4095) <= 4096 - 16) {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field));
+                    const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(padded));
+                    const auto equal = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+                    const uint32_t need = (1u << n) - 1;
+                    return (equal & need) == need;
+                }
+#endif
+                return std::memcmp(field, value.data(), n) == 0;
+            }
+
+            [[nodiscard]] bool matches(const std::string_view field) const {
+                switch (op) {
+                    case predicate::kind::equals:
+                        return field.size() == value.size() && same_bytes(field.data(), value.size());
+                    case predicate::kind::prefix:
+                        return field.size() >= value.size() && same_bytes(field.data(), value.size());
+                    case predicate::kind::range: {
+                        double number;
+                        return parse_float(field, number) == parse_status::ok && number >= min && number <= max;
+                    }
+                }
+                return false;
+            }
+        };
+    }
+}
+
+#endif //SIMDCSV_FILTER_H
@@ -0,0 +1,176 @@
+//
+// Created by lehoai on 2/18/26.
+//
+
+#ifndef SIMDCSV_INFER_H
+#define SIMDCSV_INFER_H
+
+// column profiling for schema inference
+// every sampled field narrows its column's type (boolean < int32 < int64 < float64, date32, string),
+// empty fields count as nulls, distinct values go into a HyperLogLog sketch (1KB per column)
+//
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "decode.h"
+
+namespace csv {
+
+    struct column_profile {
+        std::string name;
+        column_type type = column_type::string;   // narrowest type every non-empty sampled field fits
+        double null_rate = 0;                      // empty fields / sampled rows
+        uint64_t cardinality = 0;                  // approximate distinct non-empty values in the sample
+    };
+
+    // result of CsvReader::infer
+    struct profile {
+        std::vector<column_profile> columns;   // one per header, in file order
+        uint64_t rows = 0;                     // rows sampled
+        bool complete = false;                 // the whole file was read
+
+        // feed CsvReader::parse_typed
+        [[nodiscard]] csv::schema schema() const {
+            csv::schema out;
+            out.reserve(columns.size());
+            for (const auto& column : columns) {
+                out.push_back({column.name, column.type});
+            }
+            return out;
+        }
+    };
+
+    // options for CsvReader::infer
+    struct infer_options {
+        size_t samples = 64;              // seek points spread evenly over the file
+        size_t sample_bytes = 64 * 1024;  // bytes parsed at each seek point
+    };
+
+    namespace detail {
+        // 64-bit hash of a field, 8 bytes per step
+        inline uint64_t hash_bytes(const std::string_view s) {
+            uint64_t h = 0x9E3779B97F4A7C15ull ^ s.size();
+            size_t i = 0;
+            for (; i + 8 <= s.size(); i += 8) {
+                uint64_t w;
+                std::memcpy(&w, s.data() + i, 8);
+                h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+                h ^= h >> 32;
+            }
+            uint64_t w = 0;
+            std::memcpy(&w, s.data() + i, s.size() - i);
+            h = (h ^ w) * 0xC4CEB9FE1A85EC53ull;
+            // murmur3 finalizer
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // HyperLogLog, 2^10 registers: about 3% error, exact-ish below a few hundred values
+        class cardinality_sketch {
+        private:
+            static constexpr int BITS = 10;
+            static constexpr size_t REGISTERS = size_t{1} << BITS;
+            std::vector<uint8_t> _registers = std::vector<uint8_t>(REGISTERS);
+        public:
+            void add(const uint64_t hash) {
+                const size_t idx = hash >> (64 - BITS);
+                // sentinel bit caps the rank at 64 - BITS + 1
+                const uint64_t rest = (hash << BITS) | (uint64_t{1} << (BITS - 1));
+                const auto rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+                if (rank > _registers[idx]) _registers[idx] = rank;
+            }
+
+            [[nodiscard]] uint64_t estimate() const {
+                double sum = 0;
+                size_t zeros = 0;
+                for (const uint8_t r : _registers) {
+                    sum += std::ldexp(1.0, -r);
+                    zeros += r == 0;
+                }
+                const double m = REGISTERS;
+                double e = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+                // small range: linear counting
+                if (e <= 2.5 * m && zeros != 0) {
+                    e = m * std::log(m / static_cast<double>(zeros));
+                }
+                return static_cast<uint64_t>(e + 0.5);
+            }
+        };
+
+        // type, null and distinct tracking of one column
+        class column_profiler {
+        private:
+            uint64_t _values = 0;
+            uint64_t _nulls = 0;
+            bool _boolean = true;
+            bool _bool_word = false;   // a true/false word, not only 0/1
+            bool _int32 = true;
+            bool _int64 = true;
+            bool _float64 = true;
+            bool _date = true;
+            cardinality_sketch _distinct;
+        public:
+            void add(const std::string_view value) {
+                if (value.empty()) {
+                    _nulls++;
+                    return;
+                }
+                _values++;
+                _distinct.add(hash_bytes(value));
+
+                if (_int64) {
+                    int64_t v;
+                    if (parse_int64(value, v)) {
+                        _int32 &= v >= INT32_MIN && v <= INT32_MAX;
+                    } else {
+                        _int64 = _int32 = false;
+                    }
+                }
+                if (!_int64 && _float64) {
+                    double v;
+                    _float64 = parse_double(value, v);
+                }
+                if (_date) {
+                    int32_t v;
+                    _date = parse_date(value, v);
+                }
+                if (_boolean) {
+                    bool v;
+                    _boolean = parse_bool(value, v);
+                    _bool_word |= value[0] > '9';
+                }
+            }
+
+            [[nodiscard]] column_type type() const {
+                if (_values == 0) return column_type::string;
+                if (_boolean && _bool_word) return column_type::boolean;
+                if (_int32) return column_type::int32;
+                if (_int64) return column_type::int64;
+                if (_float64) return column_type::float64;
+                if (_date) return column_type::date32;
+                return column_type::string;
+            }
+
+            [[nodiscard]] column_profile result(std::string name) const {
+                column_profile out;
+                out.name = std::move(name);
+                out.type = type();
+                const uint64_t rows = _values + _nulls;
+                out.null_rate = rows == 0 ? 0 : static_cast<double>(_nulls) / static_cast<double>(rows);
+                out.cardinality = _values == 0 ? 0 : std::min<uint64_t>(_distinct.estimate(), _values);
+                return out;
+            }
+        };
+    }
+}
+
+#endif //SIMDCSV_INFER_H
@@ -8,6 +8,7 @@
 // mmap for linux
 // use native C api to avoid double buffer
 // destructor use for release resource, ensure munmap and close are called
+// io_mode picks how the mapping is populated, pread / direct never map (see read.h)
 //
 #ifdef _WIN32
 #include <windows.h>
@@ -16,26 +17,63 @@
 #include <fcntl.h>
 #endif
 #include <sys/stat.h>
+#include <cstdint>
 #include <stdexcept>
 #include <unistd.h>
 
+namespace csv {
+    // how a file reaches the parser
+    enum class io_mode {
+        mmap,           // MADV_SEQUENTIAL, a prefetch thread touches pages ahead of the parser
+        mmap_willneed,  // + MADV_WILLNEED: the kernel starts reading the whole file at once
+        mmap_populate,  // MAP_POPULATE: every page is read and mapped before parsing starts
+        mmap_hugepage,  // 2MB aligned mapping, MADV_HUGEPAGE + MADV_COLLAPSE where the kernel has it
+        pread,          // no mapping: sequential pread into two aligned buffers, one read ahead
+        direct,         // pread with O_DIRECT, bypasses the page cache (buffered if the fs refuses)
+    };
+
+    // how the prefetch thread of a mapped file brings pages in
+    enum class prefetch_mode {
+        touch,     // read one byte per page: the page is in and mapped before the parser gets there
+        willneed,  // MADV_WILLNEED on the window: asynchronous readahead, the parser maps the pages
+    };
+
+    // io policy of a CsvReader opened from a path
+    struct io_policy {
+        io_mode mode = io_mode::mmap;
+        size_t buffer_size = 4 * 1024 * 1024;   // pread / direct: bytes per read, rounded to 4KB
+        prefetch_mode prefetch = prefetch_mode::touch;
+        size_t prefetch_distance = 64 * 1024 * 1024;   // bytes the prefetcher keeps ahead of the parser
+    };
+}
+
 namespace csv::file {
 
     class FMmap {
     private:
         char* _data = nullptr;
         size_t _size = 0;
+        size_t _mapped = 0;   // bytes to munmap, > _size for the hugepage reservation
         int fd = -1;
+        io_mode _mode = io_mode::mmap;
+        // map with mode's flags and advice, page-aligned unless hugepage
+        void map(io_mode mode);
     public:
-        explicit FMmap(const char* file_path);
+        explicit FMmap(const char* file_path, io_mode mode = io_mode::mmap);
         ~FMmap();
+        // remap when the file grew, return false if its size did not change
+        // data() may move, a file shorter than the mapping throws
+        bool grow();
         [[nodiscard]] const char* data() const { return _data; }
         [[nodiscard]] size_t size() const { return _size; }
+        // start reading [p, p + n) of the mapping in the background
+        inline void willneed(const char* p, size_t n) const;
     };
 }
 
 #ifdef _WIN32
-inline csv::file::FMmap::FMmap(const char *file_path) {
+inline csv::file::FMmap::FMmap(const char *file_path, const io_mode mode) {
+    _mode = mode;
     // open file
     const HANDLE hFile = CreateFile(file_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
 
@@ -58,8 +96,15 @@ inline csv::file::FMmap::FMmap(const char *file_path) {
     CloseHandle(hMap);
     CloseHandle(hFile);
 }
+
+inline bool csv::file::FMmap::grow() {
+    throw std::runtime_error("Growing a mapping is not supported on Windows");
+}
+
+inline void csv::file::FMmap::willneed(const char*, size_t) const {}
 #else
-inline csv::file::FMmap::FMmap(const char *file_path) {
+inline csv::file::FMmap::FMmap(const char *file_path, const io_mode mode) {
+    _mode = mode;
     // open file
     fd = open(file_path, O_RDONLY);
     if (fd == -1) {
@@ -73,25 +118,123 @@ inline csv::file::FMmap::FMmap(const char *file_path) {
         throw std::runtime_error("Cannot get filesize");
     }
     _size = st.st_size;
+    map(mode);
+}
 
-    // native mmap
-    _data = static_cast<char *>(mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0));
-    if (_data == MAP_FAILED) {
-        close(fd);
-        throw std::runtime_error("Cannot map file");
+inline void csv::file::FMmap::map(const io_mode mode) {
+    constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+    // mmap refuses a zero length: an empty file has no mapping
+    if (_size == 0) {
+        _data = nullptr;
+        _mapped = 0;
+        return;
+    }
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (mode == io_mode::mmap_populate) flags |= MAP_POPULATE;
+#endif
+
+    if (mode == io_mode::mmap_hugepage) {
+        // huge pages need a 2MB aligned address: reserve, then map the file over the aligned part
+        _mapped = _size + HUGE_PAGE;
+        void* reserved = mmap(nullptr, _mapped, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED) {
+            close(fd);
+            fd = -1;
+            throw std::runtime_error("Cannot map file");
+        }
+        const auto base = reinterpret_cast<uintptr_t>(reserved);
+        const uintptr_t aligned = (base + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+        _data = static_cast<char *>(mmap(reinterpret_cast<void*>(aligned), _size, PROT_READ,
+                                         flags | MAP_FIXED, fd, 0));
+        if (_data == MAP_FAILED) {
+            munmap(reserved, _mapped);
+            close(fd);
+            fd = -1;
+            throw std::runtime_error("Cannot map file");
+        }
+        // give back the reservation around the file
+        if (aligned > base) munmap(reserved, aligned - base);
+        const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t tail = (aligned + _size + page - 1) & ~(page - 1);
+        if (tail < base + _mapped) munmap(reinterpret_cast<void*>(tail), base + _mapped - tail);
+        _mapped = _size;
+    } else {
+        _mapped = _size;
+        _data = static_cast<char *>(mmap(nullptr, _size, PROT_READ, flags, fd, 0));
+        if (_data == MAP_FAILED) {
+            close(fd);
+            fd = -1;
+            throw std::runtime_error("Cannot map file");
+        }
     }
 
-    // suggest kernel read contiguous, prefetch
-    madvise(_data, _size, MADV_SEQUENTIAL | MADV_HUGEPAGE); // TODO: MADV_WILLNEED?
+    // one advice per call: they are values, not flags
+    madvise(_data, _size, MADV_SEQUENTIAL);
+    switch (mode) {
+        case io_mode::mmap_willneed:
+            madvise(_data, _size, MADV_WILLNEED);
+            break;
+        case io_mode::mmap_hugepage:
+#ifdef MADV_HUGEPAGE
+            madvise(_data, _size, MADV_HUGEPAGE);
+#endif
+#ifdef MADV_COLLAPSE
+            // synchronous collapse into huge pages, fails harmlessly without file THP support
+            madvise(_data, _size, MADV_COLLAPSE);
+#endif
+            break;
+        default:
+            break;
+    }
 }
 
+inline bool csv::file::FMmap::grow() {
+    struct stat st{};
+    if (fstat(fd, &st) == -1) {
+        throw std::runtime_error("Cannot get filesize");
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    if (size < _size) {
+        throw std::runtime_error("File truncated");
+    }
+    if (size == _size) {
+        return false;
+    }
+
+#ifdef MREMAP_MAYMOVE
+    // keeps the pages already mapped, a hugepage mapping is redone to stay 2MB aligned
+    if (_data != nullptr && _mode != io_mode::mmap_hugepage) {
+        void* moved = mremap(_data, _mapped, size, MREMAP_MAYMOVE);
+        if (moved == MAP_FAILED) {
+            throw std::runtime_error("Cannot map file");
+        }
+        _data = static_cast<char *>(moved);
+        _size = _mapped = size;
+        madvise(_data, _size, MADV_SEQUENTIAL);
+        return true;
+    }
+#endif
+    if (_data != nullptr) munmap(_data, _mapped);
+    _data = nullptr;
+    _size = size;
+    map(_mode);
+    return true;
+}
+
+inline void csv::file::FMmap::willneed(const char *p, const size_t n) const {
+    // madvise wants a page aligned start
+    const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+    madvise(reinterpret_cast<void*>(start), reinterpret_cast<uintptr_t>(p) + n - start, MADV_WILLNEED);
+}
 #endif
 
 inline csv::file::FMmap::~FMmap() {
 #ifdef _WIN32
     UnmapViewOfFile(_data);
 #else
-    if (_data && _data!= MAP_FAILED) munmap(_data, _size);
+    if (_data && _data!= MAP_FAILED) munmap(_data, _mapped);
     if (fd != -1) close(fd);
 #endif
 }
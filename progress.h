@@ -0,0 +1,95 @@
+//
+// Created by lehoai on 2/28/26.
+//
+
+#ifndef SIMDCSV_PROGRESS_H
+#define SIMDCSV_PROGRESS_H
+
+// parser -> prefetcher progress without a lock on the parse path
+// the parser stores its position in an atomic every 64KB; the prefetcher sleeps on a futex until
+// the position reaches the point where it wants to refill, and only a parser crossing that point
+// makes the wake syscall. elsewhere the prefetcher polls with short sleeps
+//
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace csv::detail {
+
+    class progress {
+    private:
+        static constexpr size_t NONE = SIZE_MAX;
+
+        std::atomic<size_t> _pos{0};         // bytes parsed
+        std::atomic<size_t> _wake_at{NONE};  // a sleeping prefetcher waits for _pos to reach it
+        std::atomic<uint32_t> _seq{0};       // futex word, bumped before every wake
+        std::atomic<bool> _done{false};
+
+        inline void wake(int waiters);
+        inline void sleep(uint32_t seq);
+    public:
+        // parser: bytes parsed so far
+        void advance(const size_t pos) {
+            // seq_cst pairs with the prefetcher's store of _wake_at and load of _pos
+            _pos.store(pos);
+            size_t at = _wake_at.load();
+            if (pos >= at && _wake_at.compare_exchange_strong(at, NONE)) wake(1);
+        }
+
+        [[nodiscard]] size_t position() const { return _pos.load(std::memory_order_acquire); }
+
+        // prefetcher: block until the parser reached pos, false once finish() was called
+        inline bool wait(size_t pos);
+
+        // parser done or gone, releases a waiting prefetcher for good
+        void finish() {
+            _done.store(true);
+            wake(INT_MAX);
+        }
+    };
+}
+
+bool csv::detail::progress::wait(const size_t pos) {
+    while (!_done.load()) {
+        if (_pos.load(std::memory_order_acquire) >= pos) return true;
+        const uint32_t seq = _seq.load(std::memory_order_acquire);
+        _wake_at.store(pos);
+        // re-check after publishing: a parser that moved past pos before it saw _wake_at won't wake us
+        if (_pos.load() < pos && !_done.load()) sleep(seq);
+        _wake_at.store(NONE);
+    }
+    return false;
+}
+
+#if defined(__linux__)
+void csv::detail::progress::wake(const int waiters) {
+    _seq.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_seq), FUTEX_WAKE_PRIVATE, waiters, nullptr, nullptr, 0);
+}
+
+void csv::detail::progress::sleep(const uint32_t seq) {
+    // returns at once if a wake bumped _seq since it was read
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_seq), FUTEX_WAIT_PRIVATE, seq, nullptr, nullptr, 0);
+}
+#else
+void csv::detail::progress::wake(int) {
+    _seq.fetch_add(1, std::memory_order_release);
+}
+
+void csv::detail::progress::sleep(const uint32_t seq) {
+    if (_seq.load(std::memory_order_acquire) == seq) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+#endif
+
+#endif //SIMDCSV_PROGRESS_H
@@ -0,0 +1,201 @@
+//
+// Created by lehoai on 2/22/26.
+//
+
+#ifndef SIMDCSV_READ_H
+#define SIMDCSV_READ_H
+
+// pread input for io_mode::pread and io_mode::direct: no mapping, no page faults in the parser
+// two aligned buffers: a reader thread fills one while the parser works on the other
+// each buffer keeps `headroom` bytes in front of its read area, the unfinished row of the
+// previous buffer is copied there so rows stay contiguous
+//
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mmap.h"
+#include "stream.h"
+
+namespace csv::file {
+
+    class FRead : public FSource {
+    private:
+        static constexpr size_t ALIGN = 4096;   // O_DIRECT buffer, offset and length alignment
+
+        int fd = -1;
+        size_t _buffer = 0;        // bytes per read
+        size_t _headroom = 0;      // room for the carried row in front of each read area
+        char* _bufs[2] = {nullptr, nullptr};
+        int _back = 0;             // buffer being read into
+        uint64_t _offset = 0;      // file offset of the next read
+
+        // read-ahead thread, one request in flight at most
+        std::thread _reader;
+        std::mutex _mtx;
+        std::condition_variable _cv;
+        bool _requested = false;   // guarded by _mtx
+        bool _ready = false;       // guarded by _mtx
+        bool _stop = false;        // guarded by _mtx
+        char* _dest = nullptr;
+        uint64_t _dest_offset = 0;
+        ssize_t _got = 0;
+
+        void request(char* dest, uint64_t offset);
+        ssize_t wait();
+        void run();
+        [[nodiscard]] char* allocate(size_t headroom) const;
+    public:
+        FRead(const char* file_path, const io_policy& policy);
+        ~FRead() override;
+
+        void fill(const char* keep) override;
+    };
+}
+
+inline csv::file::FRead::FRead(const char *file_path, const io_policy &policy) {
+    _buffer = (std::max<size_t>(policy.buffer_size, ALIGN) + ALIGN - 1) & ~(ALIGN - 1);
+    _headroom = _buffer;
+
+#ifdef O_DIRECT
+    if (policy.mode == io_mode::direct) {
+        fd = open(file_path, O_RDONLY | O_DIRECT);
+    }
+#endif
+    // tmpfs and some network filesystems refuse O_DIRECT: fall back to buffered reads
+    if (fd == -1) {
+        fd = open(file_path, O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Cannot open file");
+        }
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    _bufs[0] = allocate(_headroom);
+    _bufs[1] = allocate(_headroom);
+    _reader = std::thread([this]() { run(); });
+    request(_bufs[_back] + _headroom, 0);
+}
+
+inline csv::file::FRead::~FRead() {
+    {
+        std::unique_lock lock(_mtx);
+        // a read in flight writes into _bufs, let it land first
+        _cv.wait(lock, [&] { return !_requested || _ready; });
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_reader.joinable()) _reader.join();
+    for (char* buf : _bufs) std::free(buf);
+    if (fd != -1) close(fd);
+}
+
+inline void csv::file::FRead::request(char *dest, const uint64_t offset) {
+    {
+        std::lock_guard lock(_mtx);
+        _dest = dest;
+        _dest_offset = offset;
+        _requested = true;
+        _ready = false;
+    }
+    _cv.notify_all();
+}
+
+inline ssize_t csv::file::FRead::wait() {
+    std::unique_lock lock(_mtx);
+    _cv.wait(lock, [&] { return _ready; });
+    _requested = false;
+    return _got;
+}
+
+inline void csv::file::FRead::run() {
+    while (true) {
+        char* dest;
+        uint64_t offset;
+        {
+            std::unique_lock lock(_mtx);
+            _cv.wait(lock, [&] { return _stop || (_requested && !_ready); });
+            if (_stop) return;
+            dest = _dest;
+            offset = _dest_offset;
+        }
+
+        // whole buffer or end of file
+        size_t got = 0;
+        ssize_t result = 0;
+        while (got < _buffer) {
+            const ssize_t n = pread(fd, dest + got, _buffer - got, static_cast<off_t>(offset + got));
+            if (n > 0) {
+                got += static_cast<size_t>(n);
+                continue;
+            }
+            if (n == 0) break;
+            if (errno != EINTR) {
+                result = -1;
+                break;
+            }
+        }
+
+        {
+            std::lock_guard lock(_mtx);
+            _got = result < 0 ? -1 : static_cast<ssize_t>(got);
+            _ready = true;
+        }
+        _cv.notify_all();
+    }
+}
+
+inline char* csv::file::FRead::allocate(const size_t headroom) const {
+    char* buf = static_cast<char *>(std::aligned_alloc(ALIGN, headroom + _buffer));
+    if (buf == nullptr) {
+        throw std::runtime_error("Cannot allocate read buffer");
+    }
+    return buf;
+}
+
+inline void csv::file::FRead::fill(const char *keep) {
+    const size_t kept = _size == 0 ? 0 : static_cast<size_t>(_data + _size - keep);
+    const ssize_t n = wait();
+    if (n < 0) {
+        throw std::runtime_error("Cannot read file");
+    }
+    const auto got = static_cast<size_t>(n);
+
+    char* carried_from = nullptr;
+    if (kept > _headroom) {
+        // a row longer than the headroom: bigger buffers, the finished read moves along
+        const size_t headroom = ((kept + ALIGN - 1) & ~(ALIGN - 1)) * 2;
+        char* back = allocate(headroom);
+        std::memcpy(back + headroom, _bufs[_back] + _headroom, got);
+        std::free(_bufs[_back]);
+        _bufs[_back] = back;
+        // keep points into the front buffer, free it after the copy
+        carried_from = _bufs[1 - _back];
+        _bufs[1 - _back] = allocate(headroom);
+        _headroom = headroom;
+    }
+    char* area = _bufs[_back] + _headroom;
+    // the first fill has nothing to keep, keep is nullptr then
+    if (kept > 0) std::memcpy(area - kept, keep, kept);
+    std::free(carried_from);
+
+    _data = area - kept;
+    _size = kept + got;
+    _offset += got;
+    _eof = got < _buffer;
+
+    // the old front buffer is free now: read ahead into it
+    _back = 1 - _back;
+    if (!_eof) {
+        request(_bufs[_back] + _headroom, _offset);
+    }
+}
+
+#endif //SIMDCSV_READ_H
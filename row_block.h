@@ -0,0 +1,98 @@
+//
+// Created by lehoai on 2/15/26.
+//
+
+#ifndef SIMDCSV_ROW_BLOCK_H
+#define SIMDCSV_ROW_BLOCK_H
+
+// row-major blocks: the callback runs once per block instead of once per row
+// fields are one flat array of views, row r is fields()[row_starts()[r] .. row_starts()[r + 1])
+// views into a mapped file stay valid as long as the reader lives, so rows can be kept without copying;
+// escaped fields (format.unescape) are copies in an arena of the reader, kept until the next parse_blocks
+//
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "unescape.h"
+
+namespace csv {
+
+    class RowBlock {
+    private:
+        std::vector<std::string_view> _fields;
+        std::vector<uint32_t> _row_starts;
+        size_t _width = 0;
+        size_t _rows = 0;
+    public:
+        RowBlock(size_t width, size_t capacity);
+
+        [[nodiscard]] size_t rows() const { return _rows; }
+        // fields per row (the selected columns)
+        [[nodiscard]] size_t width() const { return _width; }
+        [[nodiscard]] const std::string_view* fields() const { return _fields.data(); }
+        // rows() + 1 entries
+        [[nodiscard]] const uint32_t* row_starts() const { return _row_starts.data(); }
+        [[nodiscard]] const std::string_view* row(size_t r) const { return _fields.data() + _row_starts[r]; }
+        [[nodiscard]] std::string_view field(size_t r, size_t column) const { return _fields[_row_starts[r] + column]; }
+
+        // block building, used by the reader
+        void set(const size_t slot, const std::string_view value) { _fields[_rows * _width + slot] = value; }
+        void end_row() {
+            _rows++;
+            _row_starts[_rows] = static_cast<uint32_t>(_rows * _width);
+        }
+        void clear() { _rows = 0; }
+    };
+
+    namespace detail {
+        // fills a RowBlock and hands it to the callback every capacity rows
+        template <typename BlockCallback>
+        struct block_sink {
+            RowBlock block;
+            size_t capacity;
+            const BlockCallback& callback;
+            detail::arena scratch;
+            detail::arena* kept;   // mapped input: escaped fields outlive the block, nullptr for a stream
+
+            block_sink(const size_t width, const size_t capacity, const BlockCallback& callback, detail::arena* kept)
+                : block(width, capacity), capacity(capacity), callback(callback), kept(kept) {}
+
+            void field(const int slot, const std::string_view value) {
+                block.set(slot, value);
+            }
+
+            // every slot of the next row is written again, nothing to undo
+            void drop() {}
+
+            void row(const int) {
+                block.end_row();
+                if (block.rows() == capacity) {
+                    emit();
+                }
+            }
+
+            void flush() {
+                if (block.rows() > 0) {
+                    emit();
+                }
+            }
+
+            void emit() {
+                callback(static_cast<const RowBlock&>(block));
+                block.clear();
+                scratch.reset();
+            }
+
+            detail::arena& arena() { return kept ? *kept : scratch; }
+        };
+    }
+}
+
+inline csv::RowBlock::RowBlock(const size_t width, const size_t capacity) {
+    _width = width;
+    _fields.resize(width * capacity);
+    _row_starts.assign(capacity + 1, 0);
+}
+
+#endif //SIMDCSV_ROW_BLOCK_H
@@ -0,0 +1,203 @@
+//
+// Created by lehoai on 2/14/26.
+//
+
+#ifndef SIMDCSV_ROW_INDEX_H
+#define SIMDCSV_ROW_INDEX_H
+
+// sampled row offset index
+// the start offset of every stride-th row is kept, on disk the offsets are varint deltas
+// a row start is always outside quotes, so a sample is a safe place to restart the parser
+// the sidecar file is valid only for the same input size, mtime and format
+//
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace csv {
+
+    // identity of an indexed input, every field must match for a sidecar to be reused
+    struct index_stamp {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        char new_line = '\n';
+        char line_ending = 0;  // csv::eol
+        char quote = '\0';
+        bool has_quote = false;
+        int32_t header_row = 0;
+
+        bool operator==(const index_stamp& o) const {
+            return size == o.size && mtime_ns == o.mtime_ns && new_line == o.new_line
+                   && line_ending == o.line_ending && quote == o.quote
+                   && has_quote == o.has_quote && header_row == o.header_row;
+        }
+    };
+
+    class RowIndex {
+    private:
+        uint64_t _stride = 0;
+        uint64_t _rows = 0;
+        std::vector<uint64_t> _offsets;   // _offsets[i] = file offset of row i * stride
+    public:
+        explicit RowIndex(uint64_t stride) : _stride(stride) {}
+
+        [[nodiscard]] uint64_t stride() const { return _stride; }
+        [[nodiscard]] uint64_t rows() const { return _rows; }
+        [[nodiscard]] size_t samples() const { return _offsets.size(); }
+        [[nodiscard]] uint64_t offset(size_t sample) const { return _offsets[sample]; }
+
+        // building, offsets arrive in row order
+        void add(const uint64_t offset) { _offsets.push_back(offset); }
+        // total row count, drops samples at or past the last row
+        inline void finish(uint64_t rows);
+
+        // write atomically (temp file + rename), throws on I/O errors
+        inline void save(const std::string& path, const index_stamp& stamp) const;
+        // false when the file is missing, corrupt or stale for stamp
+        inline bool load(const std::string& path, const index_stamp& stamp);
+    };
+
+    // size and mtime of path, the format fields are left to the caller
+    inline index_stamp stamp_of(const char* path) {
+        struct stat st{};
+        if (stat(path, &st) == -1) {
+            throw std::runtime_error("Cannot stat file");
+        }
+        index_stamp stamp;
+        stamp.size = static_cast<uint64_t>(st.st_size);
+        stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return stamp;
+    }
+
+    namespace detail {
+        constexpr char INDEX_MAGIC[8] = {'S', 'C', 'S', 'V', 'I', 'D', 'X', '2'};
+
+        inline void put_varint(std::string& out, uint64_t v) {
+            while (v >= 0x80) {
+                out.push_back(static_cast<char>(v | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<char>(v));
+        }
+
+        inline bool get_varint(const char*& p, const char* end, uint64_t& v) {
+            v = 0;
+            for (int shift = 0; p < end && shift < 64; shift += 7) {
+                const auto byte = static_cast<uint8_t>(*p++);
+                v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) return true;
+            }
+            return false;
+        }
+
+        template <typename T>
+        inline void put_raw(std::string& out, const T& value) {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        inline bool get_raw(const char*& p, const char* end, T& value) {
+            if (end - p < static_cast<std::ptrdiff_t>(sizeof(T))) return false;
+            std::memcpy(&value, p, sizeof(T));
+            p += sizeof(T);
+            return true;
+        }
+    }
+}
+
+void csv::RowIndex::finish(const uint64_t rows) {
+    _rows = rows;
+    const uint64_t keep = _stride == 0 ? 0 : (rows + _stride - 1) / _stride;
+    if (_offsets.size() > keep) {
+        _offsets.resize(keep);
+    }
+}
+
+void csv::RowIndex::save(const std::string &path, const index_stamp &stamp) const {
+    // header: magic, stamp, stride, rows, samples; then one varint delta per sample
+    std::string buf(detail::INDEX_MAGIC, sizeof(detail::INDEX_MAGIC));
+    detail::put_raw(buf, stamp.size);
+    detail::put_raw(buf, stamp.mtime_ns);
+    detail::put_raw(buf, stamp.new_line);
+    detail::put_raw(buf, stamp.line_ending);
+    detail::put_raw(buf, stamp.quote);
+    detail::put_raw(buf, static_cast<char>(stamp.has_quote));
+    detail::put_raw(buf, stamp.header_row);
+    detail::put_raw(buf, _stride);
+    detail::put_raw(buf, _rows);
+    detail::put_raw(buf, static_cast<uint64_t>(_offsets.size()));
+    uint64_t prev = 0;
+    for (const uint64_t offset : _offsets) {
+        detail::put_varint(buf, offset - prev);
+        prev = offset;
+    }
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        if (!file) {
+            throw std::runtime_error("Cannot write index file");
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Cannot write index file");
+    }
+}
+
+bool csv::RowIndex::load(const std::string &path, const index_stamp &stamp) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const std::string buf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const char* p = buf.data();
+    const char* end = p + buf.size();
+
+    if (buf.size() < sizeof(detail::INDEX_MAGIC)
+        || std::memcmp(p, detail::INDEX_MAGIC, sizeof(detail::INDEX_MAGIC)) != 0) {
+        return false;
+    }
+    p += sizeof(detail::INDEX_MAGIC);
+
+    index_stamp stored;
+    char has_quote = 0;
+    uint64_t stride = 0, rows = 0, samples = 0;
+    if (!detail::get_raw(p, end, stored.size) || !detail::get_raw(p, end, stored.mtime_ns)
+        || !detail::get_raw(p, end, stored.new_line) || !detail::get_raw(p, end, stored.line_ending)
+        || !detail::get_raw(p, end, stored.quote)
+        || !detail::get_raw(p, end, has_quote) || !detail::get_raw(p, end, stored.header_row)
+        || !detail::get_raw(p, end, stride) || !detail::get_raw(p, end, rows)
+        || !detail::get_raw(p, end, samples)) {
+        return false;
+    }
+    stored.has_quote = has_quote != 0;
+    if (!(stored == stamp) || stride == 0 || samples != (rows + stride - 1) / stride
+        || samples > static_cast<uint64_t>(end - p)) {
+        return false;
+    }
+
+    std::vector<uint64_t> offsets(samples);
+    uint64_t prev = 0;
+    for (uint64_t i = 0; i < samples; i++) {
+        uint64_t delta;
+        if (!detail::get_varint(p, end, delta)) return false;
+        prev += delta;
+        if (prev > stamp.size) return false;
+        offsets[i] = prev;
+    }
+
+    _stride = stride;
+    _rows = rows;
+    _offsets = std::move(offsets);
+    return true;
+}
+
+#endif //SIMDCSV_ROW_INDEX_H
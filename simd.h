@@ -0,0 +1,555 @@
+//
+// Created by lehoai on 2/4/26.
+//
+
+#ifndef SIMDCSV_SIMD_H
+#define SIMDCSV_SIMD_H
+
+// structural kernels
+// every kernel scans 64-byte blocks and produces 64-bit masks, the parser only consumes masks
+// the best kernel is picked once at runtime (CPUID), so one binary runs on every x86-64 host
+//
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMDCSV_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define SIMDCSV_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMDCSV_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMDCSV_TARGET(isa)
+#endif
+
+namespace csv::simd {
+    constexpr size_t BLOCK = 64;
+    constexpr size_t WINDOW_BLOCKS = 64;  // blocks per kernel call (4KB input, masks stay in L1)
+
+    enum class isa { scalar, sse42, avx2, avx512 };
+
+    // bytes the kernel looks for
+    struct pattern {
+        char delimiter = ',';
+        char new_line = '\n';
+        char quote = '"';
+        bool has_quote = false;
+        bool crlf = false;     // "\r\n" ends a row: report unquoted '\r' too (new_line = '\n')
+        bool lone_cr = false;  // a '\r' not followed by '\n' ends a row as well
+    };
+
+    // masks of one 64-byte block, bit i = byte i
+    struct block_masks {
+        uint64_t sep;      // delimiter or newline outside quotes
+        uint64_t newline;  // newline outside quotes
+        uint64_t quote;    // every quote char
+        uint64_t cr;       // crlf: '\r' outside quotes, resolve_crlf() turns it into '\n' after '\r'
+    };
+
+    // scan `blocks` full blocks, return quote state after the last block
+    using scan_fn = uint64_t (*)(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, block_masks* out);
+    // quote count parity of `blocks` full blocks
+    using parity_fn = uint64_t (*)(const char* data, size_t blocks, char quote);
+
+    // newline totals of a range
+    struct newline_count {
+        uint64_t rows = 0;   // newlines outside quotes
+        uint64_t lines = 0;  // every newline, quoted ones included
+        uint64_t cr = 0;     // lone_cr: the last block ended with '\r', carried into the next call
+    };
+    // count newlines of `blocks` full blocks (no delimiter work), return quote state after the last block
+    using count_fn = uint64_t (*)(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, newline_count& out);
+
+    // writer: offset of the first byte of [data, data + size) that forces quoting
+    // (delimiter, quote, new_line, '\r' or '\n'), size if there is none; any length, no block padding
+    using special_fn = size_t (*)(const char* data, size_t size, const pattern& pat);
+
+    struct kernel {
+        isa id;
+        const char* name;
+        scan_fn scan;
+        parity_fn parity;
+        count_fn count;
+        special_fn special;
+    };
+
+    // Prefix XOR
+    // ex: 00100100 -> 00111100
+    inline uint64_t prefix_xor64(uint64_t mask) {
+        mask ^= (mask << 1);
+        mask ^= (mask << 2);
+        mask ^= (mask << 4);
+        mask ^= (mask << 8);
+        mask ^= (mask << 16);
+        mask ^= (mask << 32);
+        return mask;
+    }
+
+    // resolve quote regions of one block, shared by every kernel
+    // if in_quote = 1 -> (0 - 1) = all ones -> XOR result is NOT mask
+    // if in_quote = 0 -> XOR result is mask (keep)
+    inline void finish_block(uint64_t delim, uint64_t nl, uint64_t cr, uint64_t quote, uint64_t quote_solid,
+                             uint64_t& in_quote, block_masks& out) {
+        quote_solid ^= (0 - in_quote);
+        // if number of quote is odd, flip in_quote for next block
+        in_quote ^= static_cast<uint64_t>(__builtin_popcountll(quote) & 1);
+        out.sep = (delim | nl) & ~quote_solid;
+        out.newline = nl & ~quote_solid;
+        out.quote = quote;
+        out.cr = cr & ~quote_solid;
+    }
+
+    // count part of one block, shared by every kernel
+    // cr (lone_cr only): a '\r' is a row end unless the next byte is '\n'
+    inline void count_block(uint64_t nl, uint64_t cr, uint64_t quote, uint64_t quote_solid, uint64_t& in_quote,
+                            newline_count& out) {
+        quote_solid ^= (0 - in_quote);
+        in_quote ^= static_cast<uint64_t>(__builtin_popcountll(quote) & 1);
+        // a '\r' at bit 63 was counted as lone, its '\n' at bit 0 takes the count back
+        const uint64_t ends = nl | (cr & ~(nl >> 1));
+        const uint64_t split = nl & out.cr;
+        out.rows += __builtin_popcountll(ends & ~quote_solid) - __builtin_popcountll(split & ~quote_solid);
+        out.lines += __builtin_popcountll(ends) - __builtin_popcountll(split);
+        out.cr = cr >> 63;
+    }
+
+    // CRLF row ends for a window of kernel masks, shifted '\r' / '\n' masks instead of a byte pass
+    //   cr:      becomes the '\n' of every "\r\n", the field before it ends one byte earlier
+    //   newline: lone_cr adds every '\r' not followed by '\n' (sep too)
+    // prev_cr: the byte before the window is '\r', next_lf: the byte after the window is '\n'
+    inline void resolve_crlf(block_masks* masks, size_t blocks, uint64_t prev_cr, const uint64_t next_lf,
+                             const bool lone_cr) {
+        for (size_t b = 0; b < blocks; b++) {
+            const uint64_t cr = masks[b].cr;
+            const uint64_t lf = masks[b].newline;
+            masks[b].cr = lf & ((cr << 1) | prev_cr);
+            if (lone_cr) {
+                const uint64_t next = b + 1 < blocks ? masks[b + 1].newline & 1 : next_lf;
+                const uint64_t lone = cr & ~((lf >> 1) | (next << 63));
+                masks[b].newline |= lone;
+                masks[b].sep |= lone;
+            }
+            prev_cr = cr >> 63;
+        }
+    }
+
+    // ==================== SCALAR (SWAR) ====================
+
+    // high bit of every byte equal to b -> 8-bit mask
+    inline uint64_t swar_eq8(uint64_t word, uint64_t b) {
+        const uint64_t t = word ^ (b * 0x0101010101010101ull);
+        uint64_t y = (t & 0x7F7F7F7F7F7F7F7Full) + 0x7F7F7F7F7F7F7F7Full;
+        y = ~(y | t | 0x7F7F7F7F7F7F7F7Full);
+        return ((y >> 7) * 0x0102040810204080ull) >> 56;
+    }
+
+    inline uint64_t swar_eq64(const char* p, char c) {
+        uint64_t mask = 0;
+        for (int i = 0; i < 8; i++) {
+            uint64_t word;
+            std::memcpy(&word, p + i * 8, 8);
+            mask |= swar_eq8(word, static_cast<unsigned char>(c)) << (i * 8);
+        }
+        return mask;
+    }
+
+    inline uint64_t scan_scalar(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, block_masks* out) {
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            const uint64_t quote = pat.has_quote ? swar_eq64(p, pat.quote) : 0;
+            const uint64_t cr = pat.crlf ? swar_eq64(p, '\r') : 0;
+            finish_block(swar_eq64(p, pat.delimiter), swar_eq64(p, pat.new_line), cr, quote,
+                         prefix_xor64(quote), in_quote, out[b]);
+        }
+        return in_quote;
+    }
+
+    inline uint64_t count_scalar(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, newline_count& out) {
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            const uint64_t quote = pat.has_quote ? swar_eq64(p, pat.quote) : 0;
+            const uint64_t cr = pat.lone_cr ? swar_eq64(p, '\r') : 0;
+            count_block(swar_eq64(p, pat.new_line), cr, quote, prefix_xor64(quote), in_quote, out);
+        }
+        return in_quote;
+    }
+
+    inline uint64_t parity_scalar(const char* data, size_t blocks, char quote) {
+        uint64_t parity = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            parity ^= __builtin_popcountll(swar_eq64(data + b * BLOCK, quote));
+        }
+        return parity & 1;
+    }
+
+    inline uint64_t swar_special8(const char* p, const pattern& pat) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        const auto quote = static_cast<unsigned char>(pat.has_quote ? pat.quote : pat.delimiter);
+        return swar_eq8(word, static_cast<unsigned char>(pat.delimiter))
+               | swar_eq8(word, static_cast<unsigned char>(pat.new_line))
+               | swar_eq8(word, '\r') | swar_eq8(word, '\n') | swar_eq8(word, quote);
+    }
+
+    // the vector kernels end with an overlapping load of the last bytes, shorter inputs come here
+    inline size_t special_scalar(const char* data, size_t size, const pattern& pat) {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            const uint64_t hit = swar_special8(data + i, pat);
+            if (hit != 0) return i + __builtin_ctzll(hit);
+        }
+        if (i < size && size >= 8) {
+            // last 8 bytes again, the ones already checked masked off
+            const uint64_t hit = swar_special8(data + size - 8, pat) & (0xFFull << (8 - (size - i))) & 0xFF;
+            return hit != 0 ? size - 8 + __builtin_ctzll(hit) : size;
+        }
+        const auto quote = static_cast<unsigned char>(pat.has_quote ? pat.quote : pat.delimiter);
+        for (; i < size; i++) {
+            const char c = data[i];
+            if (c == pat.delimiter || c == pat.new_line || c == '\r' || c == '\n'
+                || static_cast<unsigned char>(c) == quote) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+#if SIMDCSV_X86
+    // ==================== SSE4.2 ====================
+
+    SIMDCSV_TARGET("sse4.2,popcnt")
+    inline uint64_t sse_eq64(const __m128i* v, __m128i c) {
+        return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v[0], c))))
+            | static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v[1], c)))) << 16
+            | static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v[2], c)))) << 32
+            | static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v[3], c)))) << 48;
+    }
+
+    SIMDCSV_TARGET("sse4.2,popcnt")
+    inline uint64_t scan_sse42(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, block_masks* out) {
+        const __m128i v_delim = _mm_set1_epi8(pat.delimiter);
+        const __m128i v_newline = _mm_set1_epi8(pat.new_line);
+        const __m128i v_quote = _mm_set1_epi8(pat.quote);
+        const __m128i v_cr = _mm_set1_epi8('\r');
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            __m128i v[4];
+            for (int i = 0; i < 4; i++) {
+                v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+            }
+            const uint64_t quote = pat.has_quote ? sse_eq64(v, v_quote) : 0;
+            const uint64_t cr = pat.crlf ? sse_eq64(v, v_cr) : 0;
+            finish_block(sse_eq64(v, v_delim), sse_eq64(v, v_newline), cr, quote,
+                         prefix_xor64(quote), in_quote, out[b]);
+        }
+        return in_quote;
+    }
+
+    SIMDCSV_TARGET("sse4.2,popcnt")
+    inline uint64_t count_sse42(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, newline_count& out) {
+        const __m128i v_newline = _mm_set1_epi8(pat.new_line);
+        const __m128i v_quote = _mm_set1_epi8(pat.quote);
+        const __m128i v_cr = _mm_set1_epi8('\r');
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            __m128i v[4];
+            for (int i = 0; i < 4; i++) {
+                v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+            }
+            const uint64_t quote = pat.has_quote ? sse_eq64(v, v_quote) : 0;
+            const uint64_t cr = pat.lone_cr ? sse_eq64(v, v_cr) : 0;
+            count_block(sse_eq64(v, v_newline), cr, quote, prefix_xor64(quote), in_quote, out);
+        }
+        return in_quote;
+    }
+
+    SIMDCSV_TARGET("sse4.2,popcnt")
+    inline uint64_t parity_sse42(const char* data, size_t blocks, char quote) {
+        const __m128i v_quote = _mm_set1_epi8(quote);
+        uint64_t parity = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            __m128i v[4];
+            for (int i = 0; i < 4; i++) {
+                v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + b * BLOCK + i * 16));
+            }
+            parity ^= __builtin_popcountll(sse_eq64(v, v_quote));
+        }
+        return parity & 1;
+    }
+
+    // bit i = byte i of the 16 at p forces quoting
+    SIMDCSV_TARGET("sse4.2,popcnt")
+    inline uint32_t special_mask_sse42(const char* p, const pattern& pat) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8(pat.has_quote ? pat.quote : pat.delimiter));
+        const __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(pat.delimiter)), _mm_cmpeq_epi8(v, _mm_set1_epi8(pat.new_line))),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))), quote));
+        return static_cast<uint32_t>(_mm_movemask_epi8(hit));
+    }
+
+    SIMDCSV_TARGET("sse4.2,popcnt")
+    inline size_t special_sse42(const char* data, size_t size, const pattern& pat) {
+        if (size < 16) {
+            // short field: one compare on a zeroed copy, bytes past size masked off
+            char block[16] = {};
+            std::memcpy(block, data, size);
+            const uint32_t mask = special_mask_sse42(block, pat) & ((1u << size) - 1);
+            return mask != 0 ? __builtin_ctz(mask) : size;
+        }
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const uint32_t mask = special_mask_sse42(data + i, pat);
+            if (mask != 0) return i + __builtin_ctz(mask);
+        }
+        if (i == size) return size;
+        // last 16 bytes again, the ones already checked masked off
+        const uint32_t mask = special_mask_sse42(data + size - 16, pat) & (0xFFFFu << (16 - (size - i)));
+        return mask != 0 ? size - 16 + __builtin_ctz(mask) : size;
+    }
+
+    // ==================== AVX2 ====================
+
+    // carry-less multiply by all ones = prefix XOR in one instruction
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline uint64_t prefix_xor_clmul(uint64_t mask) {
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(
+            _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(mask)), _mm_set1_epi8(static_cast<char>(0xFF)), 0)));
+    }
+
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline uint64_t avx2_eq64(__m256i lo, __m256i hi, __m256i c) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, c))))
+            | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, c)))) << 32;
+    }
+
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline uint64_t scan_avx2(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, block_masks* out) {
+        const __m256i v_delim = _mm256_set1_epi8(pat.delimiter);
+        const __m256i v_newline = _mm256_set1_epi8(pat.new_line);
+        const __m256i v_quote = _mm256_set1_epi8(pat.quote);
+        const __m256i v_cr = _mm256_set1_epi8('\r');
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            const uint64_t quote = pat.has_quote ? avx2_eq64(lo, hi, v_quote) : 0;
+            const uint64_t cr = pat.crlf ? avx2_eq64(lo, hi, v_cr) : 0;
+            finish_block(avx2_eq64(lo, hi, v_delim), avx2_eq64(lo, hi, v_newline), cr, quote,
+                         prefix_xor_clmul(quote), in_quote, out[b]);
+        }
+        return in_quote;
+    }
+
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline uint64_t count_avx2(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, newline_count& out) {
+        const __m256i v_newline = _mm256_set1_epi8(pat.new_line);
+        const __m256i v_quote = _mm256_set1_epi8(pat.quote);
+        const __m256i v_cr = _mm256_set1_epi8('\r');
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            const uint64_t quote = pat.has_quote ? avx2_eq64(lo, hi, v_quote) : 0;
+            const uint64_t cr = pat.lone_cr ? avx2_eq64(lo, hi, v_cr) : 0;
+            count_block(avx2_eq64(lo, hi, v_newline), cr, quote, prefix_xor_clmul(quote), in_quote, out);
+        }
+        return in_quote;
+    }
+
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline uint64_t parity_avx2(const char* data, size_t blocks, char quote) {
+        const __m256i v_quote = _mm256_set1_epi8(quote);
+        uint64_t parity = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            const char* p = data + b * BLOCK;
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            parity ^= __builtin_popcountll(avx2_eq64(lo, hi, v_quote));
+        }
+        return parity & 1;
+    }
+
+    // bit i = byte i of the 32 at p forces quoting
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline uint32_t special_mask_avx2(const char* p, const pattern& pat) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(pat.has_quote ? pat.quote : pat.delimiter));
+        const __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(pat.delimiter)),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(pat.new_line))),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))), quote));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+    }
+
+    SIMDCSV_TARGET("avx2,pclmul,popcnt")
+    inline size_t special_avx2(const char* data, size_t size, const pattern& pat) {
+        if (size < 32) {
+            // short field: one compare on a zeroed copy, bytes past size masked off
+            char block[32] = {};
+            std::memcpy(block, data, size);
+            const uint32_t mask = special_mask_avx2(block, pat) & ((1u << size) - 1);
+            return mask != 0 ? __builtin_ctz(mask) : size;
+        }
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const uint32_t mask = special_mask_avx2(data + i, pat);
+            if (mask != 0) return i + __builtin_ctz(mask);
+        }
+        if (i == size) return size;
+        // last 32 bytes again, the ones already checked masked off
+        const uint32_t mask = special_mask_avx2(data + size - 32, pat) & (~0u << (32 - (size - i)));
+        return mask != 0 ? size - 32 + __builtin_ctz(mask) : size;
+    }
+
+    // ==================== AVX-512BW ====================
+
+    SIMDCSV_TARGET("avx512f,avx512bw,pclmul,popcnt")
+    inline uint64_t scan_avx512(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, block_masks* out) {
+        const __m512i v_delim = _mm512_set1_epi8(pat.delimiter);
+        const __m512i v_newline = _mm512_set1_epi8(pat.new_line);
+        const __m512i v_quote = _mm512_set1_epi8(pat.quote);
+        const __m512i v_cr = _mm512_set1_epi8('\r');
+        const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+        for (size_t b = 0; b < blocks; b++) {
+            const __m512i v = _mm512_loadu_si512(data + b * BLOCK);
+            const uint64_t quote = pat.has_quote ? _mm512_cmpeq_epi8_mask(v, v_quote) : 0;
+            const uint64_t quote_solid = static_cast<uint64_t>(_mm_cvtsi128_si64(
+                _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(quote)), ones, 0)));
+            const uint64_t cr = pat.crlf ? _mm512_cmpeq_epi8_mask(v, v_cr) : 0;
+            finish_block(_mm512_cmpeq_epi8_mask(v, v_delim), _mm512_cmpeq_epi8_mask(v, v_newline), cr, quote,
+                         quote_solid, in_quote, out[b]);
+        }
+        return in_quote;
+    }
+
+    SIMDCSV_TARGET("avx512f,avx512bw,pclmul,popcnt")
+    inline uint64_t count_avx512(const char* data, size_t blocks, const pattern& pat, uint64_t in_quote, newline_count& out) {
+        const __m512i v_newline = _mm512_set1_epi8(pat.new_line);
+        const __m512i v_quote = _mm512_set1_epi8(pat.quote);
+        const __m512i v_cr = _mm512_set1_epi8('\r');
+        const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+        for (size_t b = 0; b < blocks; b++) {
+            const __m512i v = _mm512_loadu_si512(data + b * BLOCK);
+            const uint64_t quote = pat.has_quote ? _mm512_cmpeq_epi8_mask(v, v_quote) : 0;
+            const uint64_t quote_solid = static_cast<uint64_t>(_mm_cvtsi128_si64(
+                _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(quote)), ones, 0)));
+            const uint64_t cr = pat.lone_cr ? _mm512_cmpeq_epi8_mask(v, v_cr) : 0;
+            count_block(_mm512_cmpeq_epi8_mask(v, v_newline), cr, quote, quote_solid, in_quote, out);
+        }
+        return in_quote;
+    }
+
+    SIMDCSV_TARGET("avx512f,avx512bw,pclmul,popcnt")
+    inline uint64_t parity_avx512(const char* data, size_t blocks, char quote) {
+        const __m512i v_quote = _mm512_set1_epi8(quote);
+        uint64_t parity = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            parity ^= __builtin_popcountll(_mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + b * BLOCK), v_quote));
+        }
+        return parity & 1;
+    }
+
+    // masked loads cover the tail, bytes past size are never read
+    SIMDCSV_TARGET("avx512f,avx512bw,pclmul,popcnt")
+    inline size_t special_avx512(const char* data, size_t size, const pattern& pat) {
+        const __m512i v_delim = _mm512_set1_epi8(pat.delimiter);
+        const __m512i v_newline = _mm512_set1_epi8(pat.new_line);
+        const __m512i v_quote = _mm512_set1_epi8(pat.has_quote ? pat.quote : pat.delimiter);
+        const __m512i v_cr = _mm512_set1_epi8('\r');
+        const __m512i v_lf = _mm512_set1_epi8('\n');
+        for (size_t i = 0; i < size; i += BLOCK) {
+            const size_t left = size - i;
+            const __mmask64 live = left >= BLOCK ? ~0ull : (1ull << left) - 1;
+            const __m512i v = _mm512_maskz_loadu_epi8(live, data + i);
+            const uint64_t hit = (_mm512_cmpeq_epi8_mask(v, v_delim) | _mm512_cmpeq_epi8_mask(v, v_newline)
+                                  | _mm512_cmpeq_epi8_mask(v, v_cr) | _mm512_cmpeq_epi8_mask(v, v_lf)
+                                  | _mm512_cmpeq_epi8_mask(v, v_quote)) & live;
+            if (hit != 0) return i + __builtin_ctzll(hit);
+        }
+        return size;
+    }
+#endif
+
+    // ==================== DISPATCH ====================
+
+    inline bool supported(isa id) {
+#if SIMDCSV_X86
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_cpu_init();
+        switch (id) {
+            case isa::avx512: return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512f")
+                                     && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("popcnt");
+            case isa::avx2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")
+                                   && __builtin_cpu_supports("popcnt");
+            case isa::sse42: return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+            case isa::scalar: return true;
+        }
+        return false;
+#else
+        int info[4];
+        __cpuid(info, 1);
+        const bool popcnt = info[2] & (1 << 23);
+        const bool sse42 = (info[2] & (1 << 20)) && popcnt;
+        const bool pclmul = info[2] & (1 << 1);
+        const bool os_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+        const bool os_zmm = os_ymm && (_xgetbv(0) & 0xE6) == 0xE6;
+        __cpuidex(info, 7, 0);
+        switch (id) {
+            case isa::avx512: return os_zmm && pclmul && sse42 && (info[1] & (1 << 16)) && (info[1] & (1 << 30));
+            case isa::avx2: return os_ymm && pclmul && sse42 && (info[1] & (1 << 5));
+            case isa::sse42: return sse42;
+            case isa::scalar: return true;
+        }
+        return false;
+#endif
+#else
+        return id == isa::scalar;
+#endif
+    }
+
+    inline kernel kernel_for(isa id) {
+        switch (id) {
+#if SIMDCSV_X86
+            case isa::avx512: return {isa::avx512, "avx512", scan_avx512, parity_avx512, count_avx512, special_avx512};
+            case isa::avx2: return {isa::avx2, "avx2", scan_avx2, parity_avx2, count_avx2, special_avx2};
+            case isa::sse42: return {isa::sse42, "sse42", scan_sse42, parity_sse42, count_sse42, special_sse42};
+#endif
+            default: return {isa::scalar, "scalar", scan_scalar, parity_scalar, count_scalar, special_scalar};
+        }
+    }
+
+    // best supported kernel, SIMDCSV_KERNEL=scalar|sse42|avx2|avx512 caps the choice
+    inline kernel select_kernel() {
+        isa cap = isa::avx512;
+        if (const char* env = std::getenv("SIMDCSV_KERNEL")) {
+            const std::string_view name(env);
+            if (name == "scalar") cap = isa::scalar;
+            else if (name == "sse42") cap = isa::sse42;
+            else if (name == "avx2") cap = isa::avx2;
+        }
+        for (isa id : {isa::avx512, isa::avx2, isa::sse42}) {
+            if (static_cast<int>(id) <= static_cast<int>(cap) && supported(id)) {
+                return kernel_for(id);
+            }
+        }
+        return kernel_for(isa::scalar);
+    }
+
+    inline const kernel& active() {
+        static const kernel k = select_kernel();
+        return k;
+    }
+}
+
+#endif //SIMDCSV_SIMD_H
@@ -0,0 +1,266 @@
+//
+// Created by lehoai on 2/17/26.
+//
+
+#ifndef SIMDCSV_SNIFF_H
+#define SIMDCSV_SNIFF_H
+
+// dialect sniffing: guess csv::format from the first bytes of a file
+// 1. byte counts of the sample pick the line ending and prune absent delimiter / quote candidates
+// 2. every remaining (delimiter, quote) pair runs through the structural kernel, fields per row are
+//    popcounts of the delimiter mask between newline bits; the pair whose rows agree best wins
+// 3. leading rows with another field count are a preamble, the first consistent row is the header
+//    row; it is a header when one of its cells is text over a numeric column
+//
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_reader.h"
+
+constexpr size_t SNIFF_SAMPLE = 1024 * 1024;      // bytes read by csv::sniff(path)
+constexpr size_t SNIFF_PREAMBLE = 16;             // rows before the header row at most
+constexpr size_t SNIFF_TYPED_ROWS = 32;           // data rows checked for numeric columns
+
+namespace csv {
+
+    // result of csv::sniff
+    struct dialect {
+        csv::format format;        // delimiter, quote, line ending and header_row
+        int columns = 0;           // fields per row in the sample
+        double consistency = 0;    // share of sampled rows from the header row on with `columns` fields
+        bool header = false;       // row format.header_row looks like column names, not data
+    };
+
+    // sniff the first sample_bytes of the file
+    inline dialect sniff(const char* path, size_t sample_bytes = SNIFF_SAMPLE);
+    // bytes already in memory; complete = false: sample is a prefix, its last unterminated row is ignored
+    inline dialect sniff_sample(std::string_view sample, bool complete = true);
+
+    namespace detail {
+        constexpr char SNIFF_DELIMITERS[] = {',', ';', '\t', '|', ':'};
+        constexpr int SNIFF_MAX_FIELDS = 1024;  // larger counts share the last histogram bucket
+
+        // field counts of one candidate
+        struct sniff_rows {
+            std::vector<uint32_t> histogram = std::vector<uint32_t>(SNIFF_MAX_FIELDS + 1);
+            std::vector<int> leading;  // field count of the first rows, blank rows = 0
+            uint64_t rows = 0;         // non blank rows
+
+            void add(const int fields, const bool blank) {
+                if (leading.size() < SNIFF_PREAMBLE + 1) {
+                    leading.push_back(blank ? 0 : fields);
+                }
+                if (!blank) {
+                    histogram[std::min(fields, SNIFF_MAX_FIELDS)]++;
+                    rows++;
+                }
+            }
+        };
+
+        // walk the kernel masks of [begin, stop), rows cut by stop only count when complete
+        inline void count_fields(const char* begin, const char* stop, const bool complete,
+                                 const csv::simd::pattern& pat, sniff_rows& out) {
+            const csv::simd::kernel& kernel = csv::simd::active();
+            csv::simd::block_masks masks[csv::simd::WINDOW_BLOCKS];
+            uint64_t in_quote = 0;
+            int delimiters = 0;
+            const char* row_start = begin;
+
+            for (const char* ptr = begin; ptr < stop;) {
+                const size_t remain = stop - ptr;
+                size_t blocks = std::min(remain / csv::simd::BLOCK, csv::simd::WINDOW_BLOCKS);
+                size_t scanned = blocks * csv::simd::BLOCK;
+                if (blocks > 0) {
+                    in_quote = kernel.scan(ptr, blocks, pat, in_quote, masks);
+                } else {
+                    alignas(64) char tail[csv::simd::BLOCK] = {};
+                    std::memcpy(tail, ptr, remain);
+                    in_quote = kernel.scan(tail, 1, pat, in_quote, masks);
+                    const uint64_t valid = (1ull << remain) - 1;
+                    masks[0].sep &= valid;
+                    masks[0].newline &= valid;
+                    masks[0].cr &= valid;
+                    blocks = 1;
+                    scanned = remain;
+                }
+                if (pat.crlf) {
+                    csv::simd::resolve_crlf(masks, blocks, ptr > begin && ptr[-1] == '\r',
+                                            ptr + scanned < stop && ptr[scanned] == '\n', pat.lone_cr);
+                }
+
+                for (size_t b = 0; b < blocks; b++) {
+                    const char* block_ptr = ptr + b * csv::simd::BLOCK;
+                    uint64_t nl = masks[b].newline;
+                    uint64_t delim = masks[b].sep & ~nl;
+                    while (nl != 0) {
+                        const int offset = __builtin_ctzll(nl);
+                        const uint64_t before = (nl & (0 - nl)) - 1;
+                        delimiters += __builtin_popcountll(delim & before);
+                        delim &= ~before;
+                        // "\r\n": the row ends at the '\r'
+                        const char* row_end = block_ptr + offset - ((masks[b].cr >> offset) & 1);
+                        out.add(delimiters + 1, delimiters == 0 && row_end == row_start);
+                        delimiters = 0;
+                        row_start = block_ptr + offset + 1;
+                        nl &= nl - 1;
+                    }
+                    delimiters += __builtin_popcountll(delim);
+                }
+                ptr += scanned;
+            }
+
+            if (complete && row_start < stop) {
+                out.add(delimiters + 1, false);
+            }
+        }
+
+        inline csv::eol sniff_line_ending(const std::string_view sample, csv::format& format) {
+            const auto cr = static_cast<size_t>(std::count(sample.begin(), sample.end(), '\r'));
+            if (cr == 0) {
+                return csv::eol::single;
+            }
+            const auto lf = static_cast<size_t>(std::count(sample.begin(), sample.end(), '\n'));
+            if (lf == 0) {
+                format.new_line = '\r';
+                return csv::eol::single;
+            }
+            size_t pairs = 0;
+            for (size_t i = sample.find("\r\n"); i != std::string_view::npos; i = sample.find("\r\n", i + 2)) {
+                pairs++;
+            }
+            return pairs == cr ? csv::eol::crlf : csv::eol::any;
+        }
+
+        // numeric columns of the data rows, the header cell of one of them is text
+        inline bool looks_like_header(const char* row, const char* end, const csv::format& format, const int columns) {
+            std::vector<std::string> names;
+            row = split_row(row, end, format, [&](const std::string_view field) { names.emplace_back(field); });
+
+            std::vector<int> numeric(columns, 0), filled(columns, 0);
+            double value;
+            for (size_t r = 0; r < SNIFF_TYPED_ROWS && row != nullptr; r++) {
+                int col = 0;
+                row = split_row(row, end, format, [&](const std::string_view field) {
+                    if (col < columns && !field.empty()) {
+                        filled[col]++;
+                        numeric[col] += try_get(field, value) == parse_status::ok;
+                    }
+                    col++;
+                });
+            }
+
+            bool typed = false;
+            for (int c = 0; c < columns && c < static_cast<int>(names.size()); c++) {
+                if (filled[c] == 0 || numeric[c] < filled[c]) continue;
+                typed = true;
+                if (!names[c].empty() && try_get(names[c], value) != parse_status::ok) {
+                    return true;
+                }
+            }
+            if (typed) {
+                return false;
+            }
+            // text only: names are non-empty and distinct
+            std::vector<std::string> sorted = names;
+            std::sort(sorted.begin(), sorted.end());
+            return !names.empty() && std::find(names.begin(), names.end(), std::string()) == names.end()
+                   && std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+        }
+    }
+}
+
+csv::dialect csv::sniff(const char* path, const size_t sample_bytes) {
+    const csv::file::FMmap map(path);
+    const size_t size = std::min(map.size(), sample_bytes);
+    return sniff_sample(std::string_view(map.data(), size), size == map.size());
+}
+
+csv::dialect csv::sniff_sample(const std::string_view sample, const bool complete) {
+    csv::dialect best;
+    best.format.line_ending = detail::sniff_line_ending(sample, best.format);
+    if (sample.empty()) {
+        return best;
+    }
+
+    // candidates present in the sample, '"' beats no quote beats '\'' on a tie
+    std::vector<char> delimiters;
+    for (const char d : detail::SNIFF_DELIMITERS) {
+        if (sample.find(d) != std::string_view::npos) delimiters.push_back(d);
+    }
+    if (delimiters.empty()) delimiters.push_back(best.format.delimiter);
+    std::vector<std::optional<char>> quotes;
+    if (sample.find('"') != std::string_view::npos) quotes.emplace_back('"');
+    quotes.emplace_back(std::nullopt);
+    if (sample.find('\'') != std::string_view::npos) quotes.emplace_back('\'');
+
+    detail::sniff_rows best_rows;
+    bool found = false;
+    for (const std::optional<char>& quote : quotes) {
+        for (const char delimiter : delimiters) {
+            csv::format format = best.format;
+            format.delimiter = delimiter;
+            format.quote = quote;
+            csv::simd::pattern pat;
+            pat.delimiter = delimiter;
+            pat.new_line = format.line_ending == csv::eol::single ? format.new_line : '\n';
+            pat.quote = quote.value_or('\0');
+            pat.has_quote = quote.has_value();
+            pat.crlf = format.line_ending != csv::eol::single;
+            pat.lone_cr = format.line_ending == csv::eol::any;
+
+            detail::sniff_rows rows;
+            detail::count_fields(sample.data(), sample.data() + sample.size(), complete, pat, rows);
+            if (rows.rows == 0) continue;
+
+            const auto mode = std::max_element(rows.histogram.begin() + 1, rows.histogram.end());
+            const int columns = static_cast<int>(mode - rows.histogram.begin());
+            const double consistency = static_cast<double>(*mode) / static_cast<double>(rows.rows);
+            // one field per row means the delimiter never showed up
+            const bool better = !found
+                                || (columns > 1) > (best.columns > 1)
+                                || ((columns > 1) == (best.columns > 1)
+                                    && (consistency > best.consistency
+                                        || (consistency == best.consistency && columns > best.columns)));
+            if (better) {
+                found = true;
+                best.format = format;
+                best.columns = columns;
+                best.consistency = consistency;
+                best_rows = std::move(rows);
+            }
+        }
+    }
+    if (!found) {
+        return best;
+    }
+
+    // the first row with the common field count is the header row, rows before it a preamble
+    int header_row = 0;
+    while (header_row < static_cast<int>(best_rows.leading.size()) - 1
+           && best_rows.leading[header_row] != best.columns) {
+        header_row++;
+    }
+    if (best_rows.leading[header_row] != best.columns) {
+        header_row = 0;
+    }
+    best.format.header_row = header_row;
+    // the preamble does not count against the consistency
+    uint64_t rows = best_rows.rows;
+    for (int r = 0; r < header_row; r++) {
+        rows -= best_rows.leading[r] != 0;
+    }
+    best.consistency = static_cast<double>(best_rows.histogram[best.columns]) / static_cast<double>(rows);
+
+    const char* row = sample.data();
+    const char* end = sample.data() + sample.size();
+    for (int r = 0; r < header_row && row != nullptr; r++) {
+        row = detail::split_row(row, end, best.format, [](std::string_view) {});
+    }
+    best.header = row != nullptr && detail::looks_like_header(row, end, best.format, best.columns);
+    return best;
+}
+
+#endif //SIMDCSV_SNIFF_H
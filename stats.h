@@ -0,0 +1,164 @@
+//
+// Created by lehoai on 2/20/26.
+//
+
+#ifndef SIMDCSV_STATS_H
+#define SIMDCSV_STATS_H
+
+// parse instrumentation, compiled in only with -DSIMDCSV_STATS=1 (cmake -DSIMDCSV_STATS=ON)
+// off: CsvReader::stats() returns zeros and the parse loop holds no counter, clock or branch
+//
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#ifndef SIMDCSV_STATS
+#define SIMDCSV_STATS 0
+#endif
+
+#if SIMDCSV_STATS && (defined(__x86_64__) || defined(_M_X64))
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#if SIMDCSV_STATS && !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace csv {
+    constexpr bool STATS_ENABLED = SIMDCSV_STATS != 0;
+
+    // counters of every parse since the reader was built or reset_stats()
+    // kernel vs callback time tells kernel-bound from consumer-bound runs, ahead vs behind and
+    // major faults tell I/O-bound ones
+    struct parse_stats {
+        uint64_t bytes = 0;          // bytes run through the structural kernel
+        uint64_t rows = 0;           // rows scanned, filtered ones included
+        uint64_t fields = 0;         // fields of those rows, projected away or not
+        uint64_t quoted_blocks = 0;  // 64-byte blocks holding a quote char
+        uint64_t short_rows = 0;     // rows with fewer fields than the header
+        uint64_t long_rows = 0;      // rows with more fields than the header
+        uint64_t kernel_ns = 0;      // structural kernel (mask building)
+        uint64_t callback_ns = 0;    // sinks and user callbacks
+        uint64_t ahead_ns = 0;       // serial parse past the prefetcher, faulting pages in itself
+        uint64_t behind_ns = 0;      // serial parse on pages the prefetcher already touched
+        uint64_t minor_faults = 0;   // process-wide (getrusage) while parsing
+        uint64_t major_faults = 0;
+        uint64_t wall_ns = 0;
+
+        parse_stats& operator+=(const parse_stats& o) {
+            bytes += o.bytes;
+            rows += o.rows;
+            fields += o.fields;
+            quoted_blocks += o.quoted_blocks;
+            short_rows += o.short_rows;
+            long_rows += o.long_rows;
+            kernel_ns += o.kernel_ns;
+            callback_ns += o.callback_ns;
+            ahead_ns += o.ahead_ns;
+            behind_ns += o.behind_ns;
+            minor_faults += o.minor_faults;
+            major_faults += o.major_faults;
+            wall_ns += o.wall_ns;
+            return *this;
+        }
+    };
+
+    namespace detail {
+        inline uint64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // cheap timestamp for per-row timing: TSC on x86, steady clock ns elsewhere, 0 when off
+        inline uint64_t ticks() {
+#if SIMDCSV_STATS && (defined(__x86_64__) || defined(_M_X64))
+            return __rdtsc();
+#elif SIMDCSV_STATS
+            return now_ns();
+#else
+            return 0;
+#endif
+        }
+
+        // f(), its ticks added to total when stats are on
+        template <typename F>
+        inline void timed(uint64_t& total, const F& f) {
+            if constexpr (STATS_ENABLED) {
+                const uint64_t start = ticks();
+                f();
+                total += ticks() - start;
+            } else {
+                f();
+            }
+        }
+
+        // ticks -> ns, calibrated over the span since construction
+        class tick_clock {
+        private:
+            uint64_t _ns = STATS_ENABLED ? now_ns() : 0;
+            uint64_t _ticks = ticks();
+        public:
+            [[nodiscard]] uint64_t elapsed_ns() const { return now_ns() - _ns; }
+            [[nodiscard]] double ns_per_tick() const {
+                const uint64_t t = ticks() - _ticks;
+                return t == 0 ? 0 : static_cast<double>(elapsed_ns()) / static_cast<double>(t);
+            }
+        };
+
+        inline void page_faults(uint64_t& minor, uint64_t& major) {
+#if SIMDCSV_STATS && !defined(_WIN32)
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            minor = static_cast<uint64_t>(usage.ru_minflt);
+            major = static_cast<uint64_t>(usage.ru_majflt);
+#else
+            minor = major = 0;
+#endif
+        }
+
+        // shared by the parse threads of one reader
+        struct stats_state {
+            std::mutex mtx;
+            csv::parse_stats total;
+
+            void add(const csv::parse_stats& s) {
+                std::lock_guard lock(mtx);
+                total += s;
+            }
+        };
+
+        // wall time and page faults of one parse, added when it ends
+        class stats_scope {
+        private:
+            stats_state* _state;
+            uint64_t _start = 0;
+            uint64_t _minor = 0;
+            uint64_t _major = 0;
+        public:
+            explicit stats_scope(stats_state* state) : _state(state) {
+                if (_state == nullptr) return;
+                page_faults(_minor, _major);
+                _start = now_ns();
+            }
+
+            stats_scope(const stats_scope&) = delete;
+            stats_scope& operator=(const stats_scope&) = delete;
+
+            ~stats_scope() {
+                if (_state == nullptr) return;
+                csv::parse_stats s;
+                s.wall_ns = now_ns() - _start;
+                page_faults(s.minor_faults, s.major_faults);
+                s.minor_faults -= _minor;
+                s.major_faults -= _major;
+                _state->add(s);
+            }
+        };
+    }
+}
+
+#endif //SIMDCSV_STATS_H
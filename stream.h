@@ -0,0 +1,103 @@
+//
+// Created by lehoai on 2/9/26.
+//
+
+#ifndef SIMDCSV_STREAM_H
+#define SIMDCSV_STREAM_H
+
+// read() based input for pipes, sockets and stdin where mmap is not possible
+// one aligned buffer is reused for the whole stream, only the unfinished row at the end
+// of the buffer is moved to the front before the next read
+//
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace csv::file {
+
+    // sequential input the parser consumes one buffer at a time (FStream, FRead)
+    class FSource {
+    protected:
+        char* _data = nullptr;
+        size_t _size = 0;
+        bool _eof = false;
+    public:
+        FSource() = default;
+        virtual ~FSource() = default;
+        FSource(const FSource&) = delete;
+        FSource& operator=(const FSource&) = delete;
+
+        // keep [keep, data() + size()) in front of the next bytes; earlier data becomes invalid
+        virtual void fill(const char* keep) = 0;
+
+        [[nodiscard]] const char* data() const { return _data; }
+        [[nodiscard]] size_t size() const { return _size; }
+        [[nodiscard]] bool eof() const { return _eof; }
+    };
+
+    class FStream : public FSource {
+    private:
+        size_t _capacity = 0;
+        size_t _block = 0;
+        int fd = -1;
+    public:
+        // capacity = blocks * block_size, grows only for a row longer than the buffer
+        FStream(int fd, size_t block_size, size_t blocks);
+        ~FStream() override;
+
+        // move [keep, data() + size()) to the front and read behind it
+        void fill(const char* keep) override;
+    };
+}
+
+inline csv::file::FStream::FStream(const int fd, const size_t block_size, const size_t blocks) {
+    this->fd = fd;
+    _block = block_size;
+    _capacity = block_size * blocks;
+    _data = static_cast<char *>(std::aligned_alloc(64, _capacity));
+    if (_data == nullptr) {
+        throw std::runtime_error("Cannot allocate stream buffer");
+    }
+}
+
+inline csv::file::FStream::~FStream() {
+    std::free(_data);
+}
+
+inline void csv::file::FStream::fill(const char *keep) {
+    const size_t kept = _data + _size - keep;
+    if (kept > 0 && keep != _data) {
+        std::memmove(_data, keep, kept);
+    }
+    _size = kept;
+
+    // a row longer than the buffer: double it
+    if (_capacity - _size < _block) {
+        const size_t capacity = _capacity * 2;
+        char* grown = static_cast<char *>(std::aligned_alloc(64, capacity));
+        if (grown == nullptr) {
+            throw std::runtime_error("Cannot allocate stream buffer");
+        }
+        std::memcpy(grown, _data, _size);
+        std::free(_data);
+        _data = grown;
+        _capacity = capacity;
+    }
+
+    while (!_eof) {
+        const ssize_t n = read(fd, _data + _size, _capacity - _size);
+        if (n > 0) {
+            _size += static_cast<size_t>(n);
+            return;
+        }
+        if (n == 0) {
+            _eof = true;
+        } else if (errno != EINTR) {
+            throw std::runtime_error("Cannot read stream");
+        }
+    }
+}
+
+#endif //SIMDCSV_STREAM_H
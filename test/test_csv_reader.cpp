@@ -4,6 +4,8 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <filesystem>
+#include <map>
+#include <numeric>
 #include "csv_reader.h"
 
 namespace fs = std::filesystem;
@@ -965,4 +967,1303 @@ TEST_F(CsvReaderTest, ManyExtraFields) {
     });
 
     EXPECT_EQ(row_count, 1);
-}
\ No newline at end of file
+}
+// ==================== PARALLEL PARSE TEST CASES ====================
+
+// generate rows with quoted delimiters and quoted newlines so chunk splits land inside quotes
+static std::string makeQuotedRows(int n) {
+    std::string content = "id,name,desc\n";
+    for (int i = 0; i < n; i++) {
+        content += std::to_string(i) + ",\"name," + std::to_string(i) + "\",";
+        if (i % 7 == 0) {
+            content += "\"multi\nline " + std::to_string(i) + "\"\n";
+        } else {
+            content += "plain" + std::to_string(i) + "\n";
+        }
+    }
+    return content;
+}
+
+// Test parallel parse matches serial parse (ordered)
+TEST_F(CsvReaderTest, ParallelOrderedMatchesSerial) {
+    std::string path = createTestFile(makeQuotedRows(2000));
+
+    csv::format format;
+    format.quote = '"';
+
+    std::vector<std::string> serial;
+    csv::CsvReader reader(path.c_str(), format);
+    reader.parse([&](const std::string_view* row) {
+        serial.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+    });
+
+    csv::parallel_options options;
+    options.threads = 4;
+    options.ordered = true;
+    options.chunk_size = 97;  // tiny chunks, most splits fall inside a row or a quote
+
+    std::vector<std::string> parallel;
+    reader.parse_parallel([&](unsigned, const std::string_view* row) {
+        parallel.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+    }, options);
+
+    ASSERT_EQ(serial.size(), 2000);
+    EXPECT_EQ(parallel, serial);
+    EXPECT_EQ(parallel[7], "7|name,7|multi\nline 7");
+}
+
+// Test parallel parse (unordered) delivers every row exactly once
+TEST_F(CsvReaderTest, ParallelUnorderedAllRows) {
+    std::string path = createTestFile(makeQuotedRows(5000));
+
+    csv::format format;
+    format.quote = '"';
+
+    csv::parallel_options options;
+    options.threads = 3;
+    options.chunk_size = 1000;
+
+    std::mutex mtx;
+    std::vector<int> ids;
+    csv::CsvReader reader(path.c_str(), format);
+    reader.parse_parallel([&](unsigned worker, const std::string_view* row) {
+        EXPECT_LT(worker, 3u);
+        std::lock_guard lock(mtx);
+        ids.push_back(csv::get<int>(row[0]));
+    }, options);
+
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(ids.size(), 5000);
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(ids[i], i);
+    }
+}
+
+// Test a throwing callback reaches the caller of parse_parallel, ordered or not, and stops the workers
+TEST_F(CsvReaderTest, ParallelCallbackThrows) {
+    std::string path = createTestFile(makeQuotedRows(5000));
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+
+    for (const bool ordered : {false, true}) {
+        csv::parallel_options options;
+        options.threads = 4;
+        options.chunk_size = 1000;
+        options.ordered = ordered;
+        std::atomic<int> rows{0};
+        EXPECT_THROW(reader.parse_parallel([&](unsigned, const std::string_view* row) {
+            rows++;
+            if (csv::get<int>(row[0]) == 1234) throw std::logic_error("bad row");
+        }, options), std::logic_error) << ordered;
+        EXPECT_LT(rows.load(), 5000) << ordered;
+    }
+}
+
+// Test parallel parse without trailing newline and without quotation
+TEST_F(CsvReaderTest, ParallelNoTrailingNewline) {
+    std::string content = "a,b\n";
+    for (int i = 0; i < 300; i++) {
+        content += std::to_string(i) + "," + std::to_string(i * 2);
+        if (i != 299) content += "\n";
+    }
+    std::string path = createTestFile(content);
+
+    csv::parallel_options options;
+    options.threads = 2;
+    options.ordered = true;
+    options.chunk_size = 64;
+
+    std::vector<int> values;
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    reader.parse_parallel([&](unsigned, const std::string_view* row) {
+        values.push_back(csv::get<int>(row[1]));
+    }, options);
+
+    ASSERT_EQ(values.size(), 300);
+    EXPECT_EQ(values.back(), 598);
+}
+
+// ==================== STREAM TEST CASES ====================
+
+// Test streaming from a pipe, rows straddle many reads
+TEST_F(CsvReaderTest, StreamFromPipe) {
+    std::string content = makeQuotedRows(50000);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    std::thread writer([&]() {
+        // odd write sizes so rows and quoted newlines are cut at random places
+        size_t pos = 0;
+        size_t step = 1;
+        while (pos < content.size()) {
+            const size_t n = std::min(step, content.size() - pos);
+            ASSERT_EQ(write(fds[1], content.data() + pos, n), static_cast<ssize_t>(n));
+            pos += n;
+            step = step * 7 % 100003 + 1;
+        }
+        close(fds[1]);
+    });
+
+    csv::format format;
+    format.quote = '"';
+
+    std::vector<std::string> streamed;
+    csv::CsvReader reader(fds[0], format);
+    reader.parse([&](const std::string_view* row) {
+        streamed.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+    });
+    writer.join();
+    close(fds[0]);
+
+    std::vector<std::string> mapped;
+    std::string path = createTestFile(content);
+    csv::CsvReader file_reader(path.c_str(), format);
+    file_reader.parse([&](const std::string_view* row) {
+        mapped.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+    });
+
+    ASSERT_EQ(streamed.size(), 50000);
+    EXPECT_EQ(streamed, mapped);
+    EXPECT_EQ(reader.getHeaders(), file_reader.getHeaders());
+}
+
+// Test a row longer than the stream buffer
+TEST_F(CsvReaderTest, StreamLongRow) {
+    const std::string big(3 * 1024 * 1024, 'x');
+    std::string path = createTestFile("a,b\n1," + big + "\n2,y");
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+
+    std::vector<size_t> sizes;
+    csv::CsvReader reader(fd, csv::format{});
+    reader.parse([&](const std::string_view* row) {
+        sizes.push_back(row[1].size());
+    });
+    close(fd);
+
+    ASSERT_EQ(sizes.size(), 2);
+    EXPECT_EQ(sizes[0], big.size());
+    EXPECT_EQ(sizes[1], 1);
+    EXPECT_THROW(reader.parse([](const std::string_view*) {}), std::runtime_error);
+}
+
+// Test every io policy delivers the same rows, pread buffers cut rows, quoted newlines and a long row
+TEST_F(CsvReaderTest, IoPolicies) {
+    std::string content = makeQuotedRows(20000);
+    content += "99999,\"" + std::string(20000, 'z') + "\",end";
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    auto collect = [&](csv::CsvReader& reader) {
+        std::vector<std::string> rows;
+        reader.parse([&](const std::string_view* row) {
+            rows.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+        });
+        return rows;
+    };
+    csv::CsvReader mapped(path.c_str(), format);
+    const std::vector<std::string> expected = collect(mapped);
+    ASSERT_EQ(expected.size(), 20001);
+
+    for (const csv::io_mode mode : {csv::io_mode::mmap_willneed, csv::io_mode::mmap_populate,
+                                    csv::io_mode::mmap_hugepage, csv::io_mode::pread, csv::io_mode::direct}) {
+        csv::io_policy io;
+        io.mode = mode;
+        io.buffer_size = 4096;
+        csv::CsvReader reader(path.c_str(), format, io);
+        EXPECT_EQ(reader.getHeaders(), mapped.getHeaders());
+        EXPECT_EQ(collect(reader), expected) << static_cast<int>(mode);
+    }
+
+    csv::io_policy io;
+    io.mode = csv::io_mode::pread;
+    csv::CsvReader counted(path.c_str(), format, io);
+    EXPECT_EQ(counted.count_rows().rows, 20001);
+    EXPECT_THROW(counted.parse_parallel([](unsigned, const std::string_view*) {}), std::runtime_error);
+}
+
+// Test prefetch modes and distances down to one page give the same rows, and the progress handoff
+TEST_F(CsvReaderTest, Prefetch) {
+    std::string path = createTestFile(makeQuotedRows(60000));
+    csv::format format;
+    format.quote = '"';
+    auto collect = [&](const csv::io_policy& io) {
+        std::vector<std::string> rows;
+        csv::CsvReader reader(path.c_str(), format, io);
+        reader.parse([&](const std::string_view* row) { rows.emplace_back(row[1]); });
+        return rows;
+    };
+    const std::vector<std::string> expected = collect({});
+    ASSERT_EQ(expected.size(), 60000);
+    for (const csv::prefetch_mode mode : {csv::prefetch_mode::touch, csv::prefetch_mode::willneed}) {
+        for (const size_t distance : {size_t{0}, size_t{4096}, size_t{64 * 1024}, size_t{1} << 30}) {
+            csv::io_policy io;
+            io.prefetch = mode;
+            io.prefetch_distance = distance;
+            EXPECT_EQ(collect(io), expected) << static_cast<int>(mode) << " " << distance;
+        }
+    }
+
+    // a waiter is released by the position it waits for, or by finish()
+    csv::detail::progress progress;
+    std::atomic<int> reached{0};
+    std::thread waiter([&] {
+        if (progress.wait(1000)) reached = 1;
+        if (!progress.wait(SIZE_MAX - 1)) reached = 2;
+    });
+    for (size_t pos = 0; pos <= 2000; pos += 10) progress.advance(pos);
+    progress.finish();
+    waiter.join();
+    EXPECT_EQ(reached, 2);
+    EXPECT_EQ(progress.position(), 2000);
+    EXPECT_FALSE(progress.wait(1));
+}
+
+// Test follow on a file growing from empty: header and rows cut by appends arrive once, resume by offset
+TEST_F(CsvReaderTest, Follow) {
+    std::string path = createTestFile("");
+    auto append = [&](const std::string& text) {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << text;
+    };
+
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    int empty_rows = 0;
+    reader.parse([&](const std::string_view*) { empty_rows++; });
+    EXPECT_EQ(empty_rows, 0);
+
+    std::vector<std::string> rows;
+    auto collect = [&](const std::string_view* row) {
+        rows.push_back(std::string(row[0]) + "|" + std::string(row[1]));
+    };
+    std::thread writer([&]() {
+        for (const char* part : {"id,na", "me\n1,\"multi", "\nline\"\n2,two", "\n3,three\n"}) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            append(part);
+        }
+    });
+    csv::follow_options options;
+    options.poll = std::chrono::milliseconds(5);
+    options.idle = std::chrono::milliseconds(300);
+    const csv::follow_state state = reader.follow(collect, options);
+    writer.join();
+
+    EXPECT_EQ(reader.getHeaders(), (std::vector<std::string>{"id", "name"}));
+    EXPECT_EQ(rows, (std::vector<std::string>{"1|multi\nline", "2|two", "3|three"}));
+    EXPECT_EQ(state.rows, 3);
+    EXPECT_EQ(state.offset, fs::file_size(path));
+
+    // an unfinished last row waits for its newline, a new reader resumes at the offset
+    append("4,four\n5,fi");
+    rows.clear();
+    csv::CsvReader resumed(path.c_str(), format);
+    options.offset = state.offset;
+    options.idle = std::chrono::milliseconds(20);
+    const csv::follow_state next = resumed.follow(collect, options);
+    EXPECT_EQ(rows, (std::vector<std::string>{"4|four"}));
+    EXPECT_EQ(next.offset, fs::file_size(path) - 4);
+
+    std::atomic<bool> stop{true};
+    options.offset = next.offset;
+    options.idle = std::chrono::milliseconds(0);
+    options.stop = &stop;
+    append("ve\n");
+    rows.clear();
+    EXPECT_EQ(resumed.follow(collect, options).rows, 1);
+    EXPECT_EQ(rows, (std::vector<std::string>{"5|five"}));
+}
+
+// ==================== COLUMN BATCH TEST CASES ====================
+
+// Test column-major batches, short values inline and long values pointing into the file
+TEST_F(CsvReaderTest, ColumnBatches) {
+    std::string content = "id,name,note\n";
+    for (int i = 0; i < 10; i++) {
+        content += std::to_string(i) + ",\"name " + std::to_string(i) + "\",a long note that is not inlined " + std::to_string(i) + "\n";
+    }
+    content += "10,short\n";  // ragged row
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+
+    std::vector<size_t> batch_sizes;
+    std::vector<std::string> ids, names, notes;
+    csv::CsvReader reader(path.c_str(), format);
+    reader.parse_columns(4, [&](csv::ColumnBatch& batch) {
+        ASSERT_EQ(batch.columns(), 3);
+        EXPECT_EQ(batch.name(1), "name");
+        batch_sizes.push_back(batch.rows());
+        for (size_t r = 0; r < batch.rows(); r++) {
+            ids.emplace_back(batch.value(0, r));
+            names.emplace_back(batch.value(1, r));
+            notes.emplace_back(batch.value(2, r));
+        }
+    });
+
+    EXPECT_EQ(batch_sizes, (std::vector<size_t>{4, 4, 3}));
+    ASSERT_EQ(ids.size(), 11);
+    EXPECT_EQ(ids[3], "3");
+    EXPECT_EQ(names[3], "name 3");
+    EXPECT_EQ(notes[3], "a long note that is not inlined 3");
+    EXPECT_EQ(names[10], "short");
+    EXPECT_EQ(notes[10], "");
+}
+
+// Test Arrow C Data Interface export
+TEST_F(CsvReaderTest, ColumnBatchArrowExport) {
+    std::string path = createTestFile("k,v\nx,a value longer than twelve bytes\ny,short\n");
+
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    std::vector<ArrowArray> arrays;
+    ArrowSchema schema{};
+    reader.parse_columns(1024, [&](csv::ColumnBatch& batch) {
+        ArrowArray array{};
+        batch.export_arrow(&array, schema.release ? nullptr : &schema);
+        EXPECT_EQ(batch.rows(), 0);
+        arrays.push_back(array);
+    });
+
+    ASSERT_EQ(arrays.size(), 1);
+    ArrowArray& array = arrays[0];
+    EXPECT_STREQ(schema.format, "+s");
+    ASSERT_EQ(schema.n_children, 2);
+    EXPECT_STREQ(schema.children[1]->format, "vu");
+    EXPECT_STREQ(schema.children[1]->name, "v");
+
+    ASSERT_EQ(array.length, 2);
+    ASSERT_EQ(array.n_children, 2);
+    const ArrowArray* v = array.children[1];
+    EXPECT_EQ(v->length, 2);
+    ASSERT_EQ(v->n_buffers, 4);  // validity, views, one data buffer, sizes
+    EXPECT_EQ(v->buffers[0], nullptr);
+
+    const auto* views = static_cast<const csv::arrow_view*>(v->buffers[1]);
+    const auto* data = static_cast<const char*>(v->buffers[2 + views[0].buffer_index]);
+    EXPECT_EQ(std::string_view(data + views[0].offset, views[0].size), "a value longer than twelve bytes");
+    EXPECT_EQ(std::string_view(views[0].prefix, 4), "a va");
+    EXPECT_EQ(std::string_view(reinterpret_cast<const char*>(&views[1]) + 4, views[1].size), "short");
+    EXPECT_GE(static_cast<const int64_t*>(v->buffers[3])[0], views[0].offset + views[0].size);
+
+    // a consumer may move a child out and release it after the parent
+    ArrowArray moved = *array.children[0];
+    array.children[0]->release = nullptr;
+    array.release(&array);
+    EXPECT_EQ(array.release, nullptr);
+    moved.release(&moved);
+    schema.release(&schema);
+}
+
+// Test a data buffer holds either input or arena memory, never both
+TEST_F(CsvReaderTest, ColumnBatchArrowBuffersBySource) {
+    // unescaped values go to the arena; enough of them for several chunks, the large ones
+    // land next to the mapping
+    std::string content = "plain,quoted\n";
+    for (int i = 0; i < 20000; i++) {
+        content += "plain value number " + std::to_string(i) + ",\"quoted \"\"value\"\" number "
+                   + std::to_string(i) + "\"\n";
+    }
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+    csv::CsvReader reader(path.c_str(), format);
+
+    size_t rows = 0;
+    reader.parse_columns(20000, [&](csv::ColumnBatch& batch) {
+        ArrowArray array{};
+        const size_t n = batch.rows();
+        batch.export_arrow(&array, nullptr);
+        const auto* sizes = static_cast<const int64_t*>(array.children[0]->buffers[array.children[0]->n_buffers - 1]);
+        const int64_t buffers = array.children[0]->n_buffers - 3;
+        EXPECT_LT(buffers, 64);
+
+        std::vector<int> kind(buffers, -1);   // 0 plain, 1 quoted
+        for (int c = 0; c < 2; c++) {
+            const ArrowArray* child = array.children[c];
+            const auto* views = static_cast<const csv::arrow_view*>(child->buffers[1]);
+            for (size_t r = 0; r < n; r++) {
+                const csv::arrow_view& view = views[r];
+                ASSERT_GT(view.size, 12);
+                ASSERT_GE(view.offset, 0);
+                ASSERT_LE(view.offset + view.size, sizes[view.buffer_index]);
+                if (kind[view.buffer_index] < 0) kind[view.buffer_index] = c;
+                ASSERT_EQ(kind[view.buffer_index], c) << "buffer " << view.buffer_index << " mixes sources";
+
+                const auto* data = static_cast<const char*>(child->buffers[2 + view.buffer_index]);
+                const std::string id = std::to_string(rows + r);
+                ASSERT_EQ(std::string_view(data + view.offset, view.size),
+                          c == 0 ? "plain value number " + id : "quoted \"value\" number " + id);
+            }
+        }
+        rows += n;
+        array.release(&array);
+    });
+    EXPECT_EQ(rows, 20000);
+}
+
+// Test exported unescaped values outlive the arena reset after every batch
+TEST_F(CsvReaderTest, ColumnBatchArrowExportUnescaped) {
+    std::string content = "id,text\n";
+    for (int i = 0; i < 100; i++) {
+        content += std::to_string(i) + ",\"an \"\"escaped\"\" value " + std::to_string(i) + "\"\n";
+    }
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+    csv::CsvReader reader(path.c_str(), format);
+
+    std::vector<ArrowArray> arrays;
+    reader.parse_columns(10, [&](csv::ColumnBatch& batch) {
+        ArrowArray array{};
+        batch.export_arrow(&array, nullptr);
+        arrays.push_back(array);
+    });
+
+    ASSERT_EQ(arrays.size(), 10);
+    size_t row = 0;
+    for (ArrowArray& array : arrays) {
+        const ArrowArray* text = array.children[1];
+        const auto* views = static_cast<const csv::arrow_view*>(text->buffers[1]);
+        for (int64_t r = 0; r < array.length; r++, row++) {
+            const auto* data = static_cast<const char*>(text->buffers[2 + views[r].buffer_index]);
+            EXPECT_EQ(std::string_view(data + views[r].offset, views[r].size),
+                      "an \"escaped\" value " + std::to_string(row));
+        }
+        array.release(&array);
+    }
+    EXPECT_EQ(row, 100);
+}
+
+// Test exported arrays of a stream outlive the buffer refills, fd stream and pread reader
+TEST_F(CsvReaderTest, ColumnBatchArrowExportStream) {
+    std::string content = "id,text\n";
+    for (int i = 0; i < 40000; i++) {
+        content += std::to_string(i) + ",a value longer than twelve bytes " + std::to_string(i) + "\n";
+    }
+    std::string path = createTestFile(content);
+
+    const auto check = [](csv::CsvReader& reader) {
+        std::vector<ArrowArray> arrays;
+        reader.parse_columns(1000, [&](csv::ColumnBatch& batch) {
+            ArrowArray array{};
+            batch.export_arrow(&array, nullptr);
+            arrays.push_back(array);
+        });
+
+        size_t row = 0, wrong = 0;
+        for (ArrowArray& array : arrays) {
+            const ArrowArray* text = array.children[1];
+            const auto* views = static_cast<const csv::arrow_view*>(text->buffers[1]);
+            for (int64_t r = 0; r < array.length; r++, row++) {
+                const auto* data = static_cast<const char*>(text->buffers[2 + views[r].buffer_index]);
+                wrong += std::string_view(data + views[r].offset, views[r].size)
+                         != "a value longer than twelve bytes " + std::to_string(row);
+            }
+            array.release(&array);
+        }
+        EXPECT_EQ(row, 40000);
+        EXPECT_EQ(wrong, 0);
+    };
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    csv::CsvReader streamed(fd, csv::format{});
+    check(streamed);
+    close(fd);
+
+    csv::io_policy io;
+    io.mode = csv::io_mode::pread;
+    io.buffer_size = 4096;
+    csv::CsvReader pread(path.c_str(), csv::format{}, io);
+    check(pread);
+}
+
+// Test column batches from a stream flush at every refill
+TEST_F(CsvReaderTest, ColumnBatchesFromStream) {
+    std::string content = makeQuotedRows(20000);
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    size_t rows = 0;
+    std::string row_7;
+    csv::CsvReader reader(fd, format);
+    reader.parse_columns(1000, [&](csv::ColumnBatch& batch) {
+        for (size_t r = 0; r < batch.rows(); r++, rows++) {
+            if (rows == 7) row_7 = std::string(batch.value(2, r));
+            ASSERT_EQ(csv::get<size_t>(batch.value(0, r)), rows);
+        }
+    });
+    close(fd);
+
+    EXPECT_EQ(rows, 20000);
+    EXPECT_EQ(row_7, "multi\nline 7");
+}
+
+// ==================== PROJECTION TEST CASES ====================
+
+// Test selecting columns by name, callback gets a compact row in selection order
+TEST_F(CsvReaderTest, SelectColumnsByName) {
+    std::string path = createTestFile("a,b,c,d,e\n1,2,3,4,5\n6,7,8,9,10\n");
+
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    reader.select_columns(std::vector<std::string>{"d", "b"});
+    EXPECT_EQ(reader.selected_headers(), (std::vector<std::string>{"d", "b"}));
+
+    std::vector<std::pair<std::string, std::string>> rows;
+    reader.parse([&](const std::string_view* row) {
+        rows.emplace_back(std::string(row[0]), std::string(row[1]));
+    });
+
+    ASSERT_EQ(rows.size(), 2);
+    EXPECT_EQ(rows[0], std::make_pair(std::string("4"), std::string("2")));
+    EXPECT_EQ(rows[1], std::make_pair(std::string("9"), std::string("7")));
+}
+
+// Test projection with quoted fields past the last selected column and ragged rows
+TEST_F(CsvReaderTest, SelectColumnsSkipsRestOfRow) {
+    std::string content = "a,b,c,d\n";
+    content += "1,2,\"x,\ny\",4\n";      // skipped part holds a quoted newline
+    content += "5\n";                   // short row: selected column b is missing
+    content += "6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35\n";
+    content += "36,37";                 // no trailing newline
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<int>{1, 0});
+
+    std::vector<std::string> rows;
+    reader.parse([&](const std::string_view* row) {
+        rows.push_back(std::string(row[0]) + "|" + std::string(row[1]));
+    });
+
+    EXPECT_EQ(rows, (std::vector<std::string>{"2|1", "|5", "7|6", "37|36"}));
+}
+
+// Test projection applies to column batches and parallel parse
+TEST_F(CsvReaderTest, SelectColumnsBatchesAndParallel) {
+    std::string path = createTestFile(makeQuotedRows(3000));
+
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<std::string>{"name"});
+
+    size_t rows = 0;
+    reader.parse_columns(512, [&](csv::ColumnBatch& batch) {
+        ASSERT_EQ(batch.columns(), 1);
+        EXPECT_EQ(batch.name(0), "name");
+        for (size_t r = 0; r < batch.rows(); r++, rows++) {
+            ASSERT_EQ(batch.value(0, r), "name," + std::to_string(rows));
+        }
+    });
+    EXPECT_EQ(rows, 3000);
+
+    csv::parallel_options options;
+    options.threads = 2;
+    options.ordered = true;
+    options.chunk_size = 4096;
+    std::vector<std::string> names;
+    reader.parse_parallel([&](unsigned, const std::string_view* row) {
+        names.emplace_back(row[0]);
+    }, options);
+    ASSERT_EQ(names.size(), 3000);
+    EXPECT_EQ(names[2999], "name,2999");
+}
+
+// Test invalid selections
+TEST_F(CsvReaderTest, SelectColumnsInvalid) {
+    std::string path = createTestFile("a,b\n1,2\n");
+
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    EXPECT_THROW(reader.select_columns(std::vector<std::string>{"missing"}), std::invalid_argument);
+    EXPECT_THROW(reader.select_columns(std::vector<int>{2}), std::out_of_range);
+    EXPECT_THROW(reader.select_columns(std::vector<int>{1, 1}), std::invalid_argument);
+
+    // empty selection restores every column
+    reader.select_columns(std::vector<int>{});
+    int fields = 0;
+    reader.parse([&](const std::string_view* row) {
+        fields = static_cast<int>(row[0].size() + row[1].size());
+    });
+    EXPECT_EQ(fields, 2);
+}
+
+// Test equality, prefix and range filters
+TEST_F(CsvReaderTest, FilterRows) {
+    std::string content = "id,state,year,model\n";
+    content += "1,ca,2016,civic\n";
+    content += "2,ny,2018,accord\n";
+    content += "3,ca,2010,camry\n";
+    content += "4,ca,2020,\"corolla, le\"\n";
+    content += "5,\"ca\",2015,cr-v\n";
+    content += "6,cal,2019,fit\n";
+    content += "7,ca\n";                // short row: year is missing
+    content += "8,ca,2017,pilot";       // no trailing newline
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    reader.add_filter(csv::predicate::equals("state", "ca"));
+    reader.add_filter(csv::predicate::at_least("year", 2015));
+
+    std::vector<std::string> ids;
+    reader.parse([&](const std::string_view* row) {
+        ids.emplace_back(row[0]);
+    });
+    EXPECT_EQ(ids, (std::vector<std::string>{"1", "4", "5", "8"}));
+
+    // filtered column outside the projection, batches roll back rejected rows
+    reader.clear_filters();
+    reader.add_filter(csv::predicate::prefix("model", "c"));
+    reader.select_columns(std::vector<std::string>{"id"});
+    std::vector<std::string> batched;
+    reader.parse_columns(2, [&](csv::ColumnBatch& batch) {
+        for (size_t r = 0; r < batch.rows(); r++) batched.emplace_back(batch.value(0, r));
+    });
+    EXPECT_EQ(batched, (std::vector<std::string>{"1", "3", "4", "5"}));
+
+    EXPECT_THROW(reader.add_filter(csv::predicate::equals("missing", "x")), std::invalid_argument);
+}
+
+// Test short rows under empty-value filters: the padded missing field has no data pointer
+TEST_F(CsvReaderTest, FilterEmptyValue) {
+    std::string path = createTestFile("a,b,c\n1,x,y\n2\n3,,z\n4,x,\n");
+
+    for (const auto& predicate : {csv::predicate::equals("c", ""), csv::predicate::prefix("c", "")}) {
+        csv::CsvReader reader(path.c_str(), csv::format{});
+        reader.add_filter(predicate);
+        std::vector<std::string> ids;
+        reader.parse([&](const std::string_view* row) { ids.emplace_back(row[0]); });
+        if (predicate.op == csv::predicate::kind::equals) {
+            EXPECT_EQ(ids, (std::vector<std::string>{"2", "4"}));
+        } else {
+            EXPECT_EQ(ids, (std::vector<std::string>{"1", "2", "3", "4"}));
+        }
+    }
+}
+
+// Test filters match serial results in parallel parse
+TEST_F(CsvReaderTest, FilterParallel) {
+    std::string path = createTestFile(makeQuotedRows(5000));
+
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    reader.add_filter(csv::predicate::range("id", 1000, 1999));
+    reader.add_filter(csv::predicate::prefix("name", "name,1"));
+
+    csv::parallel_options options;
+    options.threads = 4;
+    options.ordered = true;
+    options.chunk_size = 4096;
+    std::vector<int> ids;
+    reader.parse_parallel([&](unsigned, const std::string_view* row) {
+        ids.push_back(csv::get<int>(row[0]));
+    }, options);
+
+    ASSERT_EQ(ids.size(), 1000);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(ids[i], 1000 + i);
+    }
+}
+
+// Test row index build, sidecar reuse and parse_range against a full parse
+TEST_F(CsvReaderTest, RowIndexParseRange) {
+    std::string path = createTestFile(makeQuotedRows(5000));
+
+    csv::format format;
+    format.quote = '"';
+    std::vector<std::string> all;
+    {
+        csv::CsvReader reader(path.c_str(), format);
+        reader.use_index(64);
+        EXPECT_EQ(reader.index(), nullptr);  // no sidecar yet
+        reader.parse([&](const std::string_view* row) {
+            all.emplace_back(std::string(row[0]) + "|" + std::string(row[2]));
+        });
+        ASSERT_NE(reader.index(), nullptr);  // built during parse
+        EXPECT_EQ(reader.index()->rows(), 5000);
+        EXPECT_EQ(reader.index()->samples(), (5000 + 63) / 64);
+    }
+    ASSERT_TRUE(fs::exists(path + ".idx"));
+
+    csv::CsvReader reader(path.c_str(), format);
+    reader.use_index(64);
+    ASSERT_NE(reader.index(), nullptr);  // loaded from the sidecar
+
+    for (const auto& [first, count] : std::vector<std::pair<size_t, size_t>>{
+             {0, 10}, {63, 2}, {64, 64}, {1000, 1}, {4990, 100}, {4999, 1}, {5000, 5}, {7, 0}}) {
+        std::vector<std::string> rows;
+        reader.parse_range(first, count, [&](const std::string_view* row) {
+            rows.emplace_back(std::string(row[0]) + "|" + std::string(row[2]));
+        });
+        const size_t expected = first >= all.size() ? 0 : std::min(count, all.size() - first);
+        ASSERT_EQ(rows.size(), expected) << first;
+        for (size_t i = 0; i < rows.size(); i++) {
+            EXPECT_EQ(rows[i], all[first + i]);
+        }
+    }
+}
+
+// Test a stale sidecar is rebuilt, and build_index handles a last row without newline
+TEST_F(CsvReaderTest, RowIndexStale) {
+    std::string path = createTestFile("a,b\n1,2\n3,4\n5,6\n");
+    {
+        csv::CsvReader reader(path.c_str(), csv::format{});
+        reader.build_index(2);
+        EXPECT_EQ(reader.index()->rows(), 3);
+    }
+
+    path = createTestFile("a,b\n1,2\n3,4\n5,6\n7,8\n9,10");  // different size
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    reader.use_index(2);
+    EXPECT_EQ(reader.index(), nullptr);
+
+    std::vector<std::string> rows;
+    reader.parse_range(3, 10, [&](const std::string_view* row) {
+        rows.emplace_back(row[1]);
+    });
+    EXPECT_EQ(rows, (std::vector<std::string>{"8", "10"}));
+    EXPECT_EQ(reader.index()->rows(), 5);
+    EXPECT_EQ(reader.index()->samples(), 3);
+}
+
+// Test an index sidecar that can not be written: parse, build_index and parse_range still work
+TEST_F(CsvReaderTest, RowIndexUnwritable) {
+    // a read-only directory, plus a directory in the way of the temp file for runs as root
+    const fs::path dir = test_dir / "readonly";
+    fs::create_directories(dir);
+    const std::string path = (dir / "test.csv").string();
+    std::ofstream(path, std::ios::binary) << "a,b\n1,2\n3,4\n5,6\n7,8\n";
+    fs::create_directories(path + ".idx.tmp/x");
+    fs::permissions(dir, fs::perms::owner_read | fs::perms::owner_exec);
+
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    reader.use_index(2);
+    size_t rows = 0;
+    EXPECT_NO_THROW(reader.parse([&](const std::string_view*) { rows++; }));
+    EXPECT_EQ(rows, 4);
+    ASSERT_NE(reader.index(), nullptr);
+    EXPECT_EQ(reader.index()->rows(), 4);
+    EXPECT_FALSE(fs::exists(path + ".idx"));
+
+    csv::CsvReader ranged(path.c_str(), csv::format{});
+    std::vector<std::string> values;
+    EXPECT_NO_THROW(ranged.parse_range(2, 5, [&](const std::string_view* row) { values.emplace_back(row[1]); }));
+    EXPECT_EQ(values, (std::vector<std::string>{"6", "8"}));
+    EXPECT_NO_THROW(ranged.build_index(2));
+    EXPECT_EQ(ranged.index()->samples(), 2);
+    fs::permissions(dir, fs::perms::owner_all);
+}
+
+// Test an interrupted parse resumed from serialized checkpoints delivers every row once
+TEST_F(CsvReaderTest, CheckpointResume) {
+    std::string path = createTestFile(makeQuotedRows(5000) + "5000,\"a\nb\",tail");
+
+    csv::format format;
+    format.quote = '"';
+    std::vector<std::string> all;
+    {
+        csv::CsvReader reader(path.c_str(), format);
+        reader.parse([&](const std::string_view* row) { all.emplace_back(row[0]); });
+    }
+    ASSERT_EQ(all.size(), 5001);
+
+    // checkpoint every 700 rows, the "job" dies after a few checkpoints and resumes from the last one
+    std::vector<std::string> rows;
+    std::string saved;
+    int resumes = 0;
+    struct preempted {};
+    while (true) {
+        csv::CsvReader reader(path.c_str(), format);
+        reader.add_filter(csv::predicate::at_least("id", 10));
+        const csv::checkpoint from = saved.empty() ? reader.begin_checkpoint() : csv::checkpoint::deserialize(saved);
+        EXPECT_EQ(from.row, rows.empty() ? 0 : rows.size() + 10);  // filtered rows count
+        int taken = 0;
+        try {
+            reader.parse_from(from, [&](const std::string_view* row) {
+                rows.emplace_back(row[0]);
+                return rows.size() % 700 == 0;
+            }, [&](const csv::checkpoint& checkpoint) {
+                saved = checkpoint.serialize();
+                if (++taken == 3) throw preempted{};
+            });
+            break;
+        } catch (const preempted&) {
+            resumes++;
+        }
+    }
+    all.erase(all.begin(), all.begin() + 10);
+    EXPECT_EQ(rows, all);
+    EXPECT_EQ(resumes, 2);
+
+    // another file or format is refused
+    csv::CsvReader reader(path.c_str(), format);
+    csv::checkpoint stale = csv::checkpoint::deserialize(saved);
+    stale.stamp.size++;
+    EXPECT_THROW(reader.parse_from(stale, [](const std::string_view*) {}), std::invalid_argument);
+    csv::CsvReader other(path.c_str(), csv::format{});
+    EXPECT_THROW(other.parse_from(csv::checkpoint::deserialize(saved), [](const std::string_view*) {}),
+                 std::invalid_argument);
+    EXPECT_THROW(csv::checkpoint::deserialize(saved.substr(1)), std::invalid_argument);
+}
+
+// Test dictionary codes of selected columns, filtered rows never reach the dictionary
+TEST_F(CsvReaderTest, DictionaryEncoding) {
+    std::string content = "id,city,kind\n";
+    const char* cities[] = {"Hanoi", "Da Nang", "\"Ho Chi Minh, City\"", "a city name longer than sixteen"};
+    for (int i = 0; i < 1000; i++) {
+        content += std::to_string(i) + "," + cities[i % 4] + "," + (i % 2 ? "odd" : "even") + "\n";
+    }
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<std::string>{"kind", "city"});
+    reader.add_filter(csv::predicate::at_least("id", 2));
+
+    std::vector<uint32_t> city_codes;
+    int rows = 0;
+    reader.parse_encoded({"city", "kind"}, [&](const std::string_view* row, const uint32_t* codes) {
+        EXPECT_EQ(reader.dictionary("city")->value(codes[0]), row[1]);
+        EXPECT_EQ(reader.dictionary("kind")->value(codes[1]), row[0]);
+        city_codes.push_back(codes[0]);
+        rows++;
+    });
+    ASSERT_EQ(rows, 998);
+    const csv::Dictionary* city = reader.dictionary("city");
+    ASSERT_NE(city, nullptr);
+    ASSERT_EQ(city->size(), 4);
+    // first seen order: rows 0 and 1 were filtered
+    EXPECT_EQ(city->value(0), "Ho Chi Minh, City");
+    EXPECT_EQ(city->value(1), "a city name longer than sixteen");
+    EXPECT_EQ(city->value(2), "Hanoi");
+    EXPECT_EQ(city_codes[4], 0);
+    EXPECT_EQ(reader.dictionary("kind")->value(0), "even");
+    EXPECT_EQ(reader.dictionary("id"), nullptr);
+
+    EXPECT_THROW(reader.parse_encoded({"id"}, [](const std::string_view*, const uint32_t*) {}),
+                 std::invalid_argument);
+}
+
+// Test group_by against a serial reference: parallel workers, filters, non-numeric fields, streams
+TEST_F(CsvReaderTest, GroupBy) {
+    std::string content = "region,units,price\n";
+    std::map<std::string, std::vector<double>> units, prices;
+    std::map<std::string, int> rows;
+    const char* regions[] = {"north", "south", "east", "\"west, far\"", "a region name longer than sixteen"};
+    for (int i = 0; i < 200000; i++) {
+        const std::string region = regions[(i * 7) % 5];
+        const std::string price = i % 11 == 0 ? "n/a" : std::to_string(i % 100) + ".25";
+        content += region + "," + std::to_string(i % 13) + "," + price + "\n";
+        if (i % 13 < 2) continue;  // filtered below
+        const std::string key = region.front() == '"' ? region.substr(1, region.size() - 2) : region;
+        rows[key]++;
+        units[key].push_back(i % 13);
+        if (i % 11 != 0) prices[key].push_back(i % 100 + 0.25);
+    }
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    const csv::group_query query{"region", {csv::aggregate::count(), csv::aggregate::sum("units"),
+                                            csv::aggregate::count("price"), csv::aggregate::min("price"),
+                                            csv::aggregate::max("price"), csv::aggregate::avg("price")}};
+    auto check = [&](const csv::group_table& table) {
+        ASSERT_EQ(table.columns, (std::vector<std::string>{"region", "count(*)", "sum(units)", "count(price)",
+                                                           "min(price)", "max(price)", "avg(price)"}));
+        ASSERT_EQ(table.rows.size(), rows.size());
+        auto it = rows.begin();
+        for (const auto& row : table.rows) {
+            const std::string& key = (it++)->first;
+            ASSERT_EQ(row.key, key);
+            const auto& p = prices[key];
+            const double sum = std::accumulate(p.begin(), p.end(), 0.0);
+            EXPECT_EQ(row.values[0], rows[key]);
+            EXPECT_EQ(row.values[1], std::accumulate(units[key].begin(), units[key].end(), 0.0));
+            EXPECT_EQ(row.values[2], p.size());
+            EXPECT_EQ(row.values[3], *std::min_element(p.begin(), p.end()));
+            EXPECT_EQ(row.values[4], *std::max_element(p.begin(), p.end()));
+            EXPECT_NEAR(row.values[5], sum / p.size(), 1e-9);
+        }
+    };
+
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<std::string>{"price"});
+    reader.add_filter(csv::predicate::at_least("units", 2));
+    csv::parallel_options options;
+    options.threads = 4;
+    options.chunk_size = 256 * 1024;
+    check(reader.group_by(query, options));
+    EXPECT_EQ(reader.selected_headers(), std::vector<std::string>{"price"});
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    csv::CsvReader stream(fd, format);
+    stream.add_filter(csv::predicate::at_least("units", 2));
+    check(stream.group_by(query));
+    close(fd);
+
+    // no value column: only the groups
+    csv::CsvReader plain(path.c_str(), format);
+    const csv::group_table keys = plain.group_by({"units", {csv::aggregate::avg("units")}});
+    ASSERT_EQ(keys.rows.size(), 13);
+    EXPECT_EQ(keys.rows[0].key, "0");
+    EXPECT_EQ(keys.rows[12].values[0], 9);
+    EXPECT_THROW(plain.group_by({"units", {csv::aggregate::sum("")}}), std::invalid_argument);
+    EXPECT_THROW(plain.group_by({"nope", {}}), std::invalid_argument);
+}
+
+// Test count_rows (serial, parallel, stream) against a full parse
+TEST_F(CsvReaderTest, CountRows) {
+    csv::format format;
+    format.quote = '"';
+
+    for (const std::string& content : {makeQuotedRows(7000), makeQuotedRows(7000) + "7000,\"a\nb\",tail",
+                                       std::string("a,b\n"), std::string("a,b\n1,2\n\n3,4")}) {
+        std::string path = createTestFile(content);
+        csv::CsvReader reader(path.c_str(), format);
+        uint64_t parsed = 0;
+        reader.parse([&](const std::string_view*) { parsed++; });
+
+        const size_t header = content.find('\n') + 1;
+        const auto lines = static_cast<uint64_t>(std::count(content.begin() + header, content.end(), '\n')
+                                                 + (content.back() != '\n'));
+
+        const csv::row_stats serial = reader.count_rows();
+        EXPECT_EQ(serial.rows, parsed);
+        EXPECT_EQ(serial.lines, lines);
+        EXPECT_EQ(serial.bytes, content.size() - header);
+
+        csv::parallel_options options;
+        options.threads = 4;
+        options.chunk_size = 1000;  // rounded up to whole blocks, splits land inside quotes
+        const csv::row_stats parallel = reader.count_rows_parallel(options);
+        EXPECT_EQ(parallel.rows, parsed);
+        EXPECT_EQ(parallel.lines, lines);
+        EXPECT_EQ(parallel.bytes, serial.bytes);
+
+        int fds[2];
+        ASSERT_EQ(pipe(fds), 0);
+        std::thread writer([&]() {
+            ASSERT_EQ(write(fds[1], content.data(), content.size()), static_cast<ssize_t>(content.size()));
+            close(fds[1]);
+        });
+        csv::CsvReader stream(fds[0], format);
+        const csv::row_stats streamed = stream.count_rows();
+        writer.join();
+        close(fds[0]);
+        EXPECT_EQ(streamed.rows, parsed);
+        EXPECT_EQ(streamed.lines, lines);
+        EXPECT_EQ(streamed.bytes, serial.bytes);
+    }
+}
+
+// ==================== ROW BLOCK TEST CASES ====================
+
+// Test row blocks: one callback per block, views outlive the callback for a mapped file
+TEST_F(CsvReaderTest, RowBlocks) {
+    std::string content = "id,name,note\n";
+    for (int i = 0; i < 10; i++) {
+        content += std::to_string(i) + ",\"name " + std::to_string(i) + "\",note " + std::to_string(i) + "\n";
+    }
+    content += "10,short\n";  // ragged row
+    content += "11,dropped,x\n";
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<std::string>{"note", "id"});
+    reader.add_filter(csv::predicate::at_most("id", 10));
+
+    std::vector<size_t> block_sizes;
+    std::vector<std::string_view> kept;
+    reader.parse_blocks(4, [&](const csv::RowBlock& block) {
+        ASSERT_EQ(block.width(), 2);
+        block_sizes.push_back(block.rows());
+        for (size_t r = 0; r < block.rows(); r++) {
+            ASSERT_EQ(block.row_starts()[r + 1] - block.row_starts()[r], 2);
+            EXPECT_EQ(block.row(r)[1], block.field(r, 1));
+        }
+        kept.insert(kept.end(), block.fields(), block.fields() + block.rows() * block.width());
+    });
+
+    EXPECT_EQ(block_sizes, (std::vector<size_t>{4, 4, 3}));
+    ASSERT_EQ(kept.size(), 22);
+    EXPECT_EQ(kept[6], "note 3");
+    EXPECT_EQ(kept[7], "3");
+    EXPECT_EQ(kept[20], "");
+    EXPECT_EQ(kept[21], "10");
+
+    EXPECT_THROW(reader.parse_blocks(0, [](const csv::RowBlock&) {}), std::invalid_argument);
+}
+
+// Test escaped fields kept from earlier blocks survive the later blocks
+TEST_F(CsvReaderTest, RowBlocksKeepUnescaped) {
+    std::string content = "id,text\n";
+    for (int i = 0; i < 1000; i++) {
+        content += std::to_string(i) + ",\"say \"\"" + std::to_string(i) + "\"\"\"\n";
+    }
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+    csv::CsvReader reader(path.c_str(), format);
+
+    std::vector<std::string_view> kept;
+    reader.parse_blocks(10, [&](const csv::RowBlock& block) {
+        for (size_t r = 0; r < block.rows(); r++) kept.push_back(block.field(r, 1));
+    });
+
+    ASSERT_EQ(kept.size(), 1000);
+    for (size_t i = 0; i < kept.size(); i++) {
+        ASSERT_EQ(kept[i], "say \"" + std::to_string(i) + "\"");
+    }
+}
+
+// Test row blocks from a stream, blocks are cut at every buffer refill
+TEST_F(CsvReaderTest, RowBlocksFromStream) {
+    std::string content = makeQuotedRows(20000);
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    size_t rows = 0;
+    std::string row_7;
+    csv::CsvReader reader(fd, format);
+    reader.parse_blocks(1000, [&](const csv::RowBlock& block) {
+        ASSERT_LE(block.rows(), 1000);
+        for (size_t r = 0; r < block.rows(); r++, rows++) {
+            if (rows == 7) row_7 = std::string(block.field(r, 2));
+            ASSERT_EQ(csv::get<size_t>(block.field(r, 0)), rows);
+        }
+    });
+    close(fd);
+
+    EXPECT_EQ(rows, 20000);
+    EXPECT_EQ(row_7, "multi\nline 7");
+}
+
+// ==================== UNESCAPE TEST CASES ====================
+
+// Test RFC 4180 unescaping, only fields with doubled quotes are copied
+TEST_F(CsvReaderTest, UnescapeQuotes) {
+    std::string padding(70, 'x');  // pushes escaped fields across 64-byte blocks
+    std::string content = "id,text,note\n";
+    content += "0,\"He said \"\"hi\"\"\",plain\n";
+    content += "1,\"" + padding + "\"\"" + padding + "\",\"no escapes\"\n";
+    content += "2,\"\"\"\"\"\",\"a,\"\"b\"\"\nc\"\n";
+    content += "3,\"\",\"last \"\"one\"\"\"";   // no trailing newline
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+
+    const char* map_begin = nullptr;
+    std::vector<std::vector<std::string>> rows;
+    csv::CsvReader reader(path.c_str(), format);
+    reader.parse([&](const std::string_view* row) {
+        if (rows.empty()) map_begin = row[0].data();
+        rows.push_back({std::string(row[0]), std::string(row[1]), std::string(row[2])});
+        if (rows.size() == 2) {
+            // no doubled quote: still a view into the mapping
+            EXPECT_EQ(row[2].data(), map_begin + (content.find("no escapes") - content.find("0,")));
+        }
+    });
+
+    ASSERT_EQ(rows.size(), 4);
+    EXPECT_EQ(rows[0][1], "He said \"hi\"");
+    EXPECT_EQ(rows[0][2], "plain");
+    EXPECT_EQ(rows[1][1], padding + "\"" + padding);
+    EXPECT_EQ(rows[1][2], "no escapes");
+    EXPECT_EQ(rows[2][1], "\"\"");
+    EXPECT_EQ(rows[2][2], "a,\"b\"\nc");
+    EXPECT_EQ(rows[3][1], "");
+    EXPECT_EQ(rows[3][2], "last \"one\"");
+
+    // off by default: outer quotes trimmed only
+    format.unescape = false;
+    std::string raw;
+    csv::CsvReader plain(path.c_str(), format);
+    plain.parse([&](const std::string_view* row) {
+        if (raw.empty()) raw = std::string(row[1]);
+    });
+    EXPECT_EQ(raw, "He said \"\"hi\"\"");
+}
+
+// Test unescaped fields in batches, filters and ordered parallel parsing
+TEST_F(CsvReaderTest, UnescapeBatchesAndParallel) {
+    std::string content = "id,text\n";
+    for (int i = 0; i < 5000; i++) {
+        content += std::to_string(i) + ",\"v \"\"" + std::to_string(i) + "\"\"\"\n";
+    }
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+    csv::CsvReader reader(path.c_str(), format);
+
+    size_t rows = 0;
+    reader.parse_columns(1000, [&](csv::ColumnBatch& batch) {
+        for (size_t r = 0; r < batch.rows(); r++, rows++) {
+            ASSERT_EQ(batch.value(1, r), "v \"" + std::to_string(rows) + "\"");
+        }
+    });
+    EXPECT_EQ(rows, 5000);
+
+    csv::parallel_options options;
+    options.threads = 4;
+    options.ordered = true;
+    options.chunk_size = 4096;
+    rows = 0;
+    reader.parse_parallel([&](unsigned, const std::string_view* row) {
+        ASSERT_EQ(row[1], "v \"" + std::to_string(rows) + "\"");
+        rows++;
+    }, options);
+    EXPECT_EQ(rows, 5000);
+
+    reader.add_filter(csv::predicate::equals("text", "v \"42\""));
+    std::vector<std::string> ids;
+    reader.parse([&](const std::string_view* row) { ids.emplace_back(row[0]); });
+    EXPECT_EQ(ids, (std::vector<std::string>{"42"}));
+}
+
+// ==================== LINE ENDING TEST CASES ====================
+
+static std::string toCrlf(const std::string& content) {
+    std::string out;
+    for (const char c : content) {
+        if (c == '\n') out += '\r';
+        out += c;
+    }
+    return out;
+}
+
+// Test "\r\n" files parse like their '\n' version, serial, parallel, streamed and counted
+TEST_F(CsvReaderTest, CrlfLineEndings) {
+    const std::string lf = makeQuotedRows(3000);
+    const std::string crlf = toCrlf(lf);
+
+    auto collect = [](csv::CsvReader& reader) {
+        std::vector<std::string> rows;
+        reader.parse([&](const std::string_view* row) {
+            rows.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+        });
+        return rows;
+    };
+
+    csv::format format;
+    format.quote = '"';
+    std::vector<std::string> expected;
+    {
+        std::string path = createTestFile(lf);
+        csv::CsvReader reader(path.c_str(), format);
+        for (const auto& row : collect(reader)) expected.push_back(toCrlf(row));  // quoted newlines stay "\r\n"
+    }
+    ASSERT_EQ(expected.size(), 3000);
+
+    std::string path = createTestFile(crlf);
+    for (const csv::eol line_ending : {csv::eol::crlf, csv::eol::any}) {
+        format.line_ending = line_ending;
+        csv::CsvReader reader(path.c_str(), format);
+        EXPECT_EQ(reader.getHeaders(), (std::vector<std::string>{"id", "name", "desc"}));
+        EXPECT_EQ(collect(reader), expected);
+
+        csv::parallel_options options;
+        options.threads = 4;
+        options.ordered = true;
+        options.chunk_size = 4096;
+        std::vector<std::string> parallel;
+        reader.parse_parallel([&](unsigned, const std::string_view* row) {
+            parallel.push_back(std::string(row[0]) + "|" + std::string(row[1]) + "|" + std::string(row[2]));
+        }, options);
+        EXPECT_EQ(parallel, expected);
+
+        const csv::row_stats stats = reader.count_rows();
+        EXPECT_EQ(stats.rows, 3000);
+        EXPECT_EQ(stats.lines, static_cast<uint64_t>(std::count(crlf.begin(), crlf.end(), '\n') - 1));
+        options.chunk_size = 1000;
+        const csv::row_stats parallel_stats = reader.count_rows_parallel(options);
+        EXPECT_EQ(parallel_stats.rows, stats.rows);
+        EXPECT_EQ(parallel_stats.lines, stats.lines);
+
+        // odd write sizes cut "\r\n" pairs between reads
+        int fds[2];
+        ASSERT_EQ(pipe(fds), 0);
+        std::thread writer([&]() {
+            size_t pos = 0;
+            size_t step = 1;
+            while (pos < crlf.size()) {
+                const size_t n = std::min(step, crlf.size() - pos);
+                ASSERT_EQ(write(fds[1], crlf.data() + pos, n), static_cast<ssize_t>(n));
+                pos += n;
+                step = step * 7 % 100003 + 1;
+            }
+            close(fds[1]);
+        });
+        csv::CsvReader stream(fds[0], format);
+        EXPECT_EQ(collect(stream), expected);
+        writer.join();
+        close(fds[0]);
+    }
+}
+
+// Test eol::any mixes "\r\n", '\n' and lone '\r', eol::crlf keeps a lone '\r' as data
+TEST_F(CsvReaderTest, AnyLineEnding) {
+    const std::string content = "a,b\r\n1,2\r3,4\n5,\"x\ry\"\r\r\n6,\"7\"\r";
+    std::string path = createTestFile(content);
+
+    csv::format format;
+    format.quote = '"';
+    format.line_ending = csv::eol::any;
+
+    std::vector<std::string> rows;
+    csv::CsvReader reader(path.c_str(), format);
+    reader.parse([&](const std::string_view* row) {
+        rows.push_back(std::string(row[0]) + "|" + std::string(row[1]));
+    });
+    EXPECT_EQ(rows, (std::vector<std::string>{"1|2", "3|4", "5|x\ry", "|", "6|7"}));
+    const csv::row_stats stats = reader.count_rows();
+    EXPECT_EQ(stats.rows, 5);
+    EXPECT_EQ(stats.lines, 6);
+
+    reader.build_index(2);
+    std::vector<std::string> range;
+    reader.parse_range(3, 2, [&](const std::string_view* row) {
+        range.push_back(std::string(row[0]) + "|" + std::string(row[1]));
+    });
+    EXPECT_EQ(range, (std::vector<std::string>{"|", "6|7"}));
+
+    format.line_ending = csv::eol::crlf;
+    rows.clear();
+    csv::CsvReader crlf(path.c_str(), format);
+    crlf.parse([&](const std::string_view* row) {
+        rows.push_back(std::string(row[0]) + "|" + std::string(row[1]));
+    });
+    EXPECT_EQ(rows, (std::vector<std::string>{"1|2\r3", "5|\"x\ry\"\r", "6|\"7\"\r"}));
+}
@@ -0,0 +1,138 @@
+//
+// Created by lehoai on 2/21/26.
+//
+#include <gtest/gtest.h>
+#include <fstream>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include "dataset.h"
+
+namespace fs = std::filesystem;
+
+class DatasetTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / "csv_dataset_test";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+
+    // rows "<file>-<i>" with a quoted multi-line note
+    std::string write(const std::string& name, const int file, const int rows) const {
+        const auto path = dir / name;
+        std::ofstream out(path, std::ios::binary);
+        out << "id,note,value\n";
+        for (int i = 0; i < rows; i++) {
+            out << file << '-' << i << ",\"line " << i << ",\nnext\"," << i * 3 << '\n';
+        }
+        return path.string();
+    }
+};
+
+TEST(WildcardTest, Match) {
+    EXPECT_TRUE(csv::detail::wildcard_match("*.csv", "day-01.csv"));
+    EXPECT_TRUE(csv::detail::wildcard_match("day-??.csv", "day-01.csv"));
+    EXPECT_TRUE(csv::detail::wildcard_match("*", ""));
+    EXPECT_TRUE(csv::detail::wildcard_match("a*b*c", "aXbYbZc"));
+    EXPECT_FALSE(csv::detail::wildcard_match("*.csv", "day-01.csv.idx"));
+    EXPECT_FALSE(csv::detail::wildcard_match("day-?.csv", "day-01.csv"));
+}
+
+// small files batched, large ones split, every row exactly once and in order within its file
+TEST_F(DatasetTest, SplitsAndBatches) {
+    const int sizes[] = {3, 2000, 0, 17, 1, 5000, 40};
+    std::vector<std::string> paths;
+    for (int f = 0; f < 7; f++) {
+        paths.push_back(write("part-" + std::to_string(f) + ".csv", f, sizes[f]));
+    }
+
+    csv::format format;
+    format.quote = '"';
+    csv::Dataset dataset(paths, format);
+    ASSERT_EQ(dataset.files(), 7);
+    EXPECT_EQ(dataset.getHeaders(), (std::vector<std::string>{"id", "note", "value"}));
+
+    csv::dataset_options options;
+    options.threads = 4;
+    options.chunk_size = 4096;
+
+    std::mutex mtx;
+    std::map<size_t, std::vector<std::string>> rows;
+    std::set<unsigned> workers;
+    dataset.parse([&](const unsigned worker, const size_t file, const std::string_view* row) {
+        std::lock_guard lock(mtx);
+        workers.insert(worker);
+        EXPECT_EQ(row[1].substr(0, 5), "line ");
+        rows[file].emplace_back(row[0]);
+    }, options);
+
+    for (size_t f = 0; f < 7; f++) {
+        std::vector<std::string>& got = rows[f];
+        ASSERT_EQ(got.size(), static_cast<size_t>(sizes[f])) << dataset.path(f);
+        // chunks of a split file may interleave, sort by row number
+        std::sort(got.begin(), got.end(), [](const std::string& a, const std::string& b) {
+            return std::stoi(a.substr(a.find('-') + 1)) < std::stoi(b.substr(b.find('-') + 1));
+        });
+        for (int i = 0; i < sizes[f]; i++) {
+            ASSERT_EQ(got[i], std::to_string(f) + "-" + std::to_string(i));
+        }
+    }
+    EXPECT_LT(*workers.rbegin(), options.threads);
+}
+
+TEST_F(DatasetTest, GlobProjectionAndFilter) {
+    write("b.csv", 1, 50);
+    write("a.csv", 0, 50);
+    write("notes.txt", 9, 5);
+
+    csv::format format;
+    format.quote = '"';
+    csv::Dataset dataset(dir.string(), "*.csv", format);
+    ASSERT_EQ(dataset.files(), 2);
+    EXPECT_EQ(fs::path(dataset.path(0)).filename(), "a.csv");
+    dataset.select_columns({"value", "id"});
+    dataset.add_filter(csv::predicate::prefix("id", "1-"));
+    EXPECT_THROW(dataset.select_columns({"missing"}), std::invalid_argument);
+
+    std::mutex mtx;
+    std::vector<std::string> rows;
+    dataset.parse([&](unsigned, const size_t file, const std::string_view* row) {
+        std::lock_guard lock(mtx);
+        EXPECT_EQ(file, 1);
+        rows.push_back(std::string(row[1]) + "=" + std::string(row[0]));
+    });
+    ASSERT_EQ(rows.size(), 50);
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ(rows[0], "1-0=0");
+}
+
+TEST_F(DatasetTest, HeaderMismatch) {
+    const std::string a = write("a.csv", 0, 3);
+    const auto b = dir / "b.csv";
+    std::ofstream(b, std::ios::binary) << "id,value\n1,2\n";
+    EXPECT_THROW(csv::Dataset({a, b.string()}, csv::format{}), std::invalid_argument);
+}
+
+// a file removed after the dataset was built throws to the caller instead of ending the process
+TEST_F(DatasetTest, MissingFileThrows) {
+    std::vector<std::string> paths;
+    for (int f = 0; f < 6; f++) paths.push_back(write("part-" + std::to_string(f) + ".csv", f, 20));
+    const csv::Dataset shards(paths, csv::format{});
+    fs::remove(paths[3]);
+
+    csv::dataset_options options;
+    options.threads = 3;
+    options.chunk_size = 600;  // two files per task, opened by the workers
+    EXPECT_THROW(shards.parse([](unsigned, size_t, const std::string_view*) {}, options), std::runtime_error);
+    EXPECT_THROW(shards.parse([](unsigned, size_t, const std::string_view*) { throw std::runtime_error("stop"); },
+                              options), std::runtime_error);
+}
@@ -0,0 +1,311 @@
+//
+// Created by lehoai on 2/11/26.
+//
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include "csv_reader.h"
+
+namespace fs = std::filesystem;
+
+TEST(DecodeTest, Digits8) {
+    uint32_t v = 0;
+    uint64_t w;
+    std::memcpy(&w, "12345678", 8);
+    ASSERT_TRUE(csv::parse_digits8(w, 8, v));
+    EXPECT_EQ(v, 12345678u);
+
+    std::memcpy(&w, "907xxxxx", 8);
+    ASSERT_TRUE(csv::parse_digits8(w, 3, v));  // bytes past n are ignored
+    EXPECT_EQ(v, 907u);
+
+    std::memcpy(&w, "12a45678", 8);
+    EXPECT_FALSE(csv::parse_digits8(w, 8, v));
+    std::memcpy(&w, "12/45678", 8);
+    EXPECT_FALSE(csv::parse_digits8(w, 8, v));
+    std::memcpy(&w, "12:45678", 8);
+    EXPECT_FALSE(csv::parse_digits8(w, 8, v));
+}
+
+TEST(DecodeTest, ParseInt64) {
+    int64_t v = 0;
+    ASSERT_TRUE(csv::parse_int64("0", v));
+    EXPECT_EQ(v, 0);
+    ASSERT_TRUE(csv::parse_int64("-42", v));
+    EXPECT_EQ(v, -42);
+    ASSERT_TRUE(csv::parse_int64("+123456789012", v));
+    EXPECT_EQ(v, 123456789012);
+    ASSERT_TRUE(csv::parse_int64("9223372036854775807", v));
+    EXPECT_EQ(v, INT64_MAX);
+    ASSERT_TRUE(csv::parse_int64("-9223372036854775808", v));
+    EXPECT_EQ(v, INT64_MIN);
+
+    EXPECT_FALSE(csv::parse_int64("9223372036854775808", v));
+    EXPECT_FALSE(csv::parse_int64("99999999999999999999", v));
+    EXPECT_FALSE(csv::parse_int64("", v));
+    EXPECT_FALSE(csv::parse_int64("-", v));
+    EXPECT_FALSE(csv::parse_int64("12 ", v));
+    EXPECT_FALSE(csv::parse_int64("1.5", v));
+}
+
+// SWAR result must match std::from_chars for every length
+TEST(DecodeTest, ParseInt64MatchesFromChars) {
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 200000; i++) {
+        const int64_t expected = static_cast<int64_t>(rng()) >> (rng() % 64);
+        const std::string text = std::to_string(expected);
+        int64_t v = 0;
+        ASSERT_TRUE(csv::parse_int64(text, v)) << text;
+        ASSERT_EQ(v, expected) << text;
+    }
+}
+
+TEST(DecodeTest, ParseBool) {
+    bool v = false;
+    ASSERT_TRUE(csv::parse_bool("TRUE", v));
+    EXPECT_TRUE(v);
+    ASSERT_TRUE(csv::parse_bool("f", v));
+    EXPECT_FALSE(v);
+    ASSERT_TRUE(csv::parse_bool("1", v));
+    EXPECT_TRUE(v);
+    EXPECT_FALSE(csv::parse_bool("yes", v));
+    EXPECT_FALSE(csv::parse_bool("", v));
+}
+
+TEST(DecodeTest, TypedBatches) {
+    const auto path = fs::temp_directory_path() / "csv_decode_test.csv";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "id,name,price,active,big\n";
+        file << "1,alpha,10.5,true,1234567890123456\n";
+        file << "2,beta,,false,-5\n";
+        file << "x,gamma,3e2,1,\n";
+        file << "2147483648,,abc,maybe,7\n";
+    }
+
+    csv::schema schema = {
+        {"big", csv::column_type::int64},
+        {"id", csv::column_type::int32},
+        {"price", csv::column_type::float64},
+        {"active", csv::column_type::boolean},
+        {"name", csv::column_type::string},
+    };
+
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    size_t rows = 0;
+    reader.parse_typed(schema, 3, [&](const csv::TypedBatch& batch) {
+        ASSERT_EQ(batch.columns(), 5);
+        if (rows == 0) {
+            ASSERT_EQ(batch.rows(), 3);
+            const auto& big = batch.column(0);
+            EXPECT_EQ(big.int64_values[0], 1234567890123456);
+            EXPECT_EQ(big.int64_values[1], -5);
+            EXPECT_FALSE(big.valid(2));
+            EXPECT_EQ(big.invalid_count, 0);
+
+            const auto& id = batch.column(1);
+            EXPECT_EQ(id.int32_values[1], 2);
+            EXPECT_FALSE(id.valid(2));
+            EXPECT_EQ(id.invalid_count, 1);
+
+            const auto& price = batch.column(2);
+            EXPECT_DOUBLE_EQ(price.float64_values[0], 10.5);
+            EXPECT_FALSE(price.valid(1));
+            EXPECT_DOUBLE_EQ(price.float64_values[2], 300.0);
+            EXPECT_EQ(price.null_count, 1);
+
+            const auto& active = batch.column(3);
+            EXPECT_TRUE(active.bool_value(0));
+            EXPECT_FALSE(active.bool_value(1));
+            EXPECT_TRUE(active.bool_value(2));
+
+            EXPECT_EQ(batch.string(4, 1), "beta");
+        } else {
+            ASSERT_EQ(batch.rows(), 1);
+            EXPECT_FALSE(batch.column(1).valid(0));  // int32 overflow
+            EXPECT_EQ(batch.column(1).invalid_count, 1);
+            EXPECT_FALSE(batch.column(2).valid(0));
+            EXPECT_FALSE(batch.column(3).valid(0));
+            EXPECT_FALSE(batch.column(4).valid(0));
+            EXPECT_EQ(batch.column(0).int64_values[0], 7);
+        }
+        rows += batch.rows();
+    });
+    EXPECT_EQ(rows, 4);
+
+    // projection restored
+    EXPECT_EQ(reader.selected_headers().size(), 5);
+    EXPECT_EQ(reader.selected_headers()[0], "id");
+    fs::remove(path);
+}
+
+TEST(DecodeTest, ParseDate) {
+    int32_t v = -1;
+    ASSERT_TRUE(csv::parse_date("1970-01-01", v));
+    EXPECT_EQ(v, 0);
+    ASSERT_TRUE(csv::parse_date("2000-03-01", v));
+    EXPECT_EQ(v, 11017);
+    ASSERT_TRUE(csv::parse_date("1969-12-31", v));
+    EXPECT_EQ(v, -1);
+    ASSERT_TRUE(csv::parse_date("2024-02-29", v));
+    EXPECT_EQ(v, 19782);
+    EXPECT_FALSE(csv::parse_date("2023-02-29", v));
+    EXPECT_FALSE(csv::parse_date("2024-13-01", v));
+    EXPECT_FALSE(csv::parse_date("2024-1-01", v));
+    EXPECT_FALSE(csv::parse_date("2024/01/01", v));
+    EXPECT_FALSE(csv::parse_date("", v));
+}
+
+TEST(DecodeTest, InferSampled) {
+    const auto path = fs::temp_directory_path() / "csv_infer_test.csv";
+    constexpr int ROWS = 40000;
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "id,big,price,flag,day,city,note,maybe\n";
+        const char* cities[] = {"hanoi", "tokyo", "paris", "lima", "oslo"};
+        std::mt19937 rng(7);
+        for (int i = 0; i < ROWS; i++) {
+            file << i << ',' << 5000000000ll + i << ',' << (i % 100) / 4.0 << ','
+                 << (i % 3 == 0 ? "true" : "false") << ','
+                 << "2024-0" << 1 + i % 9 << '-' << 10 + i % 19 << ','
+                 << cities[rng() % 5] << ','
+                 // quoted delimiters and newlines around every seek point
+                 << "\"line " << i << ",\nmore\"" << ','
+                 << (i % 4 == 0 ? std::string() : std::to_string(i % 7)) << '\n';
+        }
+    }
+
+    csv::infer_options options;
+    options.samples = 16;
+    options.sample_bytes = 4096;
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<std::string>{"city"});
+    const csv::profile profile = reader.infer(options);
+
+    EXPECT_FALSE(profile.complete);
+    EXPECT_GT(profile.rows, 500u);
+    EXPECT_LT(profile.rows, ROWS / 4u);
+    ASSERT_EQ(profile.columns.size(), 8);
+    const csv::column_type expected[] = {
+        csv::column_type::int32, csv::column_type::int64, csv::column_type::float64,
+        csv::column_type::boolean, csv::column_type::date32, csv::column_type::string,
+        csv::column_type::string, csv::column_type::int32,
+    };
+    for (int c = 0; c < 8; c++) {
+        EXPECT_EQ(profile.columns[c].type, expected[c]) << profile.columns[c].name;
+    }
+    EXPECT_EQ(profile.columns[5].cardinality, 5u);
+    EXPECT_EQ(profile.columns[3].cardinality, 2u);
+    EXPECT_NEAR(static_cast<double>(profile.columns[0].cardinality), static_cast<double>(profile.rows),
+                profile.rows * 0.1);
+    EXPECT_NEAR(profile.columns[7].null_rate, 0.25, 0.02);
+    EXPECT_EQ(profile.columns[0].null_rate, 0);
+
+    // the schema drives typed decoding, the caller's projection is back
+    EXPECT_EQ(reader.selected_headers(), (std::vector<std::string>{"city"}));
+    size_t rows = 0, dates = 0;
+    reader.parse_typed(profile.schema(), 8192, [&](const csv::TypedBatch& batch) {
+        ASSERT_EQ(batch.columns(), 8);
+        for (size_t c = 0; c < 8; c++) {
+            if (c != 7) {
+                EXPECT_EQ(batch.column(c).invalid_count, 0) << c;
+            }
+        }
+        if (rows == 0) {
+            EXPECT_EQ(batch.column(4).int32_values[0], 19732);  // 2024-01-10
+            EXPECT_EQ(batch.column(1).int64_values[1], 5000000001);
+        }
+        dates += batch.rows() - batch.column(4).null_count;
+        rows += batch.rows();
+    });
+    EXPECT_EQ(rows, ROWS);
+    EXPECT_EQ(dates, ROWS);
+
+    // small files are read whole
+    options.samples = 4;
+    options.sample_bytes = 1 << 20;
+    EXPECT_TRUE(reader.infer(options).complete);
+    EXPECT_EQ(reader.infer(options).rows, ROWS);
+    fs::remove(path);
+}
+
+// Test windows spaced between 1x and 2x sample_bytes: a window that starts late behind a long row
+// must stop at the next window's first row instead of sampling its rows again
+TEST(DecodeTest, InferOverlappingWindows) {
+    const auto path = fs::temp_directory_path() / "csv_infer_overlap.csv";
+    // 6000-byte blocks, one per seek point: even blocks open with a 3504-byte row, then 12-byte rows
+    constexpr int BLOCKS = 20;
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "id,pad\n";
+        char id[16];
+        int n = 0;
+        for (int b = 0; b < BLOCKS; b++) {
+            int bytes = 0;
+            if (b % 2 == 0) {
+                std::snprintf(id, sizeof(id), "%09d", n++);
+                file << id << ',' << std::string(3493, 'x') << '\n';
+                bytes = 3504;
+            }
+            for (; bytes < 6000; bytes += 12) {
+                std::snprintf(id, sizeof(id), "%09d", n++);
+                file << id << ",a\n";
+            }
+        }
+    }
+
+    csv::infer_options options;
+    options.samples = BLOCKS;
+    options.sample_bytes = 4096;
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    const csv::profile profile = reader.infer(options);
+
+    EXPECT_FALSE(profile.complete);
+    // window 0 from the first row: the long row and 49 short ones within 4096 bytes
+    // even windows start behind their long row and end at the next window's first row, 209 rows;
+    // odd windows start at their second row, 341 rows within 4096 bytes
+    EXPECT_EQ(profile.rows, 50u + 9 * 209u + 10 * 341u);
+    fs::remove(path);
+}
+
+// Test sampling an unquoted file with a quote char set: the inside-quote guess at each seek point
+// must give up at the sample window instead of scanning to the end of the file
+TEST(DecodeTest, InferRareQuotes) {
+    const auto path = fs::temp_directory_path() / "csv_infer_rare.csv";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "id,name,value\n";
+        for (int i = 0; i < 600000; i++) {
+            file << i << ",name" << i % 97 << ',' << i * 0.5 << '\n';
+        }
+    }
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t parsed = 0;
+    reader.parse([&](const std::string_view*) { parsed++; });
+    const auto parse_time = std::chrono::steady_clock::now() - start;
+
+    csv::infer_options options;
+    options.samples = 64;
+    options.sample_bytes = 4096;
+    const auto infer_start = std::chrono::steady_clock::now();
+    const csv::profile profile = reader.infer(options);
+    const auto infer_time = std::chrono::steady_clock::now() - infer_start;
+
+    EXPECT_EQ(parsed, 600000u);
+    EXPECT_FALSE(profile.complete);
+    EXPECT_GT(profile.rows, 64u * 100);
+    EXPECT_EQ(profile.columns[0].type, csv::column_type::int32);
+    EXPECT_EQ(profile.columns[2].type, csv::column_type::float64);
+    // 64 windows of 4KB against a full pass over ~13MB
+    EXPECT_LT(infer_time, parse_time);
+    fs::remove(path);
+}
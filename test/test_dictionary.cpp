@@ -0,0 +1,43 @@
+//
+// Created by lehoai on 2/26/26.
+//
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "dictionary.h"
+
+// Test codes against a reference map: short, 16-byte, long keys, shared prefixes, growth
+TEST(DictionaryTest, MatchesReference) {
+    std::mt19937 rng(11);
+    std::vector<std::string> keys = {"", "a", "ab", std::string(16, 'x'), std::string(17, 'x'),
+                                     std::string("a\0b", 3), std::string("a\0c", 3)};
+    for (int i = 0; i < 3000; i++) {
+        // long keys share their first 16 bytes so the tail compare decides
+        std::string key = i % 3 == 0 ? std::string(16, 'p') : "";
+        const size_t size = rng() % 40;
+        for (size_t c = 0; c < size; c++) key += static_cast<char>('a' + rng() % 4);
+        keys.push_back(key);
+    }
+
+    csv::Dictionary dict(4);
+    std::unordered_map<std::string, uint32_t> reference;
+    for (int round = 0; round < 2; round++) {
+        for (const auto& key : keys) {
+            const auto it = reference.emplace(key, static_cast<uint32_t>(reference.size())).first;
+            ASSERT_EQ(dict.encode(key), it->second) << key;
+        }
+    }
+    ASSERT_EQ(dict.size(), reference.size());
+    for (const auto& [key, code] : reference) {
+        EXPECT_EQ(dict.find(key), code);
+        EXPECT_EQ(dict.value(code), key);
+    }
+    EXPECT_EQ(dict.find(std::string(16, 'p') + "zz"), csv::Dictionary::NONE);
+
+    dict.clear();
+    EXPECT_EQ(dict.size(), 0);
+    EXPECT_EQ(dict.find("a"), csv::Dictionary::NONE);
+    EXPECT_EQ(dict.encode("b"), 0);
+}
@@ -0,0 +1,131 @@
+//
+// Created by lehoai on 2/12/26.
+//
+#include <gtest/gtest.h>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+#include "csv_reader.h"
+
+namespace {
+    // bit-exact comparison against the standard library
+    template <typename T>
+    void expectSameAsFromChars(const std::string& s) {
+        T expected{};
+        const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), expected);
+        ASSERT_EQ(ptr, s.data() + s.size()) << s;
+
+        T value{};
+        const csv::parse_status status = csv::parse_float(s, value);
+        if (ec == std::errc::result_out_of_range) {
+            EXPECT_EQ(status, csv::parse_status::out_of_range) << s;
+            return;
+        }
+        ASSERT_EQ(ec, std::errc()) << s;
+        ASSERT_EQ(status, csv::parse_status::ok) << s;
+        EXPECT_EQ(std::memcmp(&value, &expected, sizeof(T)), 0) << s;
+    }
+}
+
+TEST(NumberTest, ShortDecimals) {
+    for (const char* s : {"0", "0.0", "1", "-1", "12345.67", "0.5", ".5", "5.", "3.14159", "-78.9",
+                          "1e10", "-2.5e-3", "1E+5", "0.1", "0.3", "99999999.99", "123456789012345"}) {
+        expectSameAsFromChars<double>(s);
+        expectSameAsFromChars<float>(s);
+    }
+}
+
+TEST(NumberTest, HardCases) {
+    for (const char* s : {"9007199254740993",          // 2^53 + 1, ties to even
+                          "9007199254740995",
+                          "0.1234567890123456789",     // 19 digits
+                          "1.7976931348623157e308",    // max double
+                          "2.2250738585072014e-308",   // min normal
+                          "4.9e-324",                  // subnormal
+                          "123456789012345678901234567890",
+                          "0.000000000000000000000000000001",
+                          "1e-45", "3.4028235e38", "16777217",
+                          "7.038531e-26",              // halfway for float
+                          "1e22", "1e23", "1e-22", "1e-23", "1e63", "1e-64", "1e65", "1e-65"}) {
+        expectSameAsFromChars<double>(s);
+        expectSameAsFromChars<float>(s);
+    }
+}
+
+TEST(NumberTest, RandomRoundTrip) {
+    std::mt19937_64 rng(42);
+    char buf[64];
+    for (int i = 0; i < 200000; i++) {
+        uint64_t bits = rng();
+        double d;
+        std::memcpy(&d, &bits, 8);
+        if (!std::isfinite(d)) continue;
+        std::snprintf(buf, sizeof(buf), "%.17g", d);
+        expectSameAsFromChars<double>(buf);
+        std::snprintf(buf, sizeof(buf), "%.*e", static_cast<int>(rng() % 17), d);
+        expectSameAsFromChars<double>(buf);
+    }
+}
+
+TEST(NumberTest, RandomDecimals) {
+    // csv shaped values: up to 19 digits, a few decimals, exponents around the table
+    std::mt19937_64 rng(7);
+    char buf[64];
+    for (int i = 0; i < 200000; i++) {
+        const uint64_t w = rng() % 10000000000000000000ull >> (rng() % 64);
+        const int decimals = static_cast<int>(rng() % 8);
+        const int exponent = static_cast<int>(rng() % 160) - 80;
+        std::snprintf(buf, sizeof(buf), "%" PRIu64 "e%d", w, exponent);
+        expectSameAsFromChars<double>(buf);
+        expectSameAsFromChars<float>(buf);
+
+        const uint64_t p = [decimals] { uint64_t r = 1; for (int k = 0; k < decimals; k++) r *= 10; return r; }();
+        std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%0*" PRIu64, w / p, decimals, w % p);
+        if (decimals == 0) buf[std::strlen(buf) - 1] = '\0';
+        expectSameAsFromChars<double>(buf);
+        expectSameAsFromChars<float>(buf);
+    }
+}
+
+TEST(NumberTest, Status) {
+    double d = 1;
+    EXPECT_EQ(csv::parse_float("", d), csv::parse_status::empty);
+    EXPECT_EQ(csv::parse_float("abc", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("12abc", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("1.5 ", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("1e", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("1e+", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("-", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float(".", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("+-1", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("--1", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("1.2.3", d), csv::parse_status::invalid);
+    EXPECT_EQ(csv::parse_float("1e400", d), csv::parse_status::out_of_range);
+
+    ASSERT_EQ(csv::parse_float("+1.5", d), csv::parse_status::ok);
+    EXPECT_EQ(d, 1.5);
+    ASSERT_EQ(csv::parse_float("-0", d), csv::parse_status::ok);
+    EXPECT_TRUE(std::signbit(d));
+    ASSERT_EQ(csv::parse_float("-inf", d), csv::parse_status::ok);
+    EXPECT_TRUE(std::isinf(d) && d < 0);
+    ASSERT_EQ(csv::parse_float("nan", d), csv::parse_status::ok);
+    EXPECT_TRUE(std::isnan(d));
+
+    float f = 0;
+    EXPECT_EQ(csv::parse_float("1e39", f), csv::parse_status::out_of_range);
+}
+
+TEST(NumberTest, TryGet) {
+    int i = 0;
+    EXPECT_EQ(csv::try_get("42", i), csv::parse_status::ok);
+    EXPECT_EQ(i, 42);
+    EXPECT_EQ(csv::try_get("", i), csv::parse_status::empty);
+    EXPECT_EQ(csv::try_get("4x", i), csv::parse_status::invalid);
+    EXPECT_EQ(csv::try_get("99999999999", i), csv::parse_status::out_of_range);
+
+    double d = 0;
+    EXPECT_EQ(csv::try_get("4.25", d), csv::parse_status::ok);
+    EXPECT_EQ(d, 4.25);
+    EXPECT_EQ(csv::get<double>("oops"), 0.0);
+    EXPECT_EQ(csv::get<float>("2.5"), 2.5f);
+}
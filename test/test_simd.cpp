@@ -0,0 +1,219 @@
+//
+// Created by lehoai on 2/8/26.
+//
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include "simd.h"
+
+namespace {
+    // byte-at-a-time reference for one scan
+    std::vector<csv::simd::block_masks> referenceScan(const std::string& data, const csv::simd::pattern& pat) {
+        std::vector<csv::simd::block_masks> out(data.size() / csv::simd::BLOCK);
+        bool in_quote = false;
+        for (size_t i = 0; i < out.size() * csv::simd::BLOCK; i++) {
+            auto& m = out[i / csv::simd::BLOCK];
+            const uint64_t bit = 1ull << (i % csv::simd::BLOCK);
+            if (i % csv::simd::BLOCK == 0) m = {};
+            const char c = data[i];
+            if (pat.has_quote && c == pat.quote) {
+                m.quote |= bit;
+                in_quote = !in_quote;
+                continue;
+            }
+            if (in_quote) continue;
+            if (c == pat.delimiter) m.sep |= bit;
+            if (c == pat.new_line) {
+                m.sep |= bit;
+                m.newline |= bit;
+            }
+        }
+        return out;
+    }
+
+    std::string randomCsvBytes(size_t size, unsigned seed) {
+        const char alphabet[] = {'a', 'b', ',', ',', '\n', '"', '1', ';', '\t', ' '};
+        std::mt19937 rng(seed);
+        std::string data(size, ' ');
+        for (auto& c : data) {
+            c = alphabet[rng() % sizeof(alphabet)];
+        }
+        return data;
+    }
+
+    std::vector<csv::simd::isa> supportedKernels() {
+        std::vector<csv::simd::isa> ids;
+        for (auto id : {csv::simd::isa::scalar, csv::simd::isa::sse42, csv::simd::isa::avx2, csv::simd::isa::avx512}) {
+            if (csv::simd::supported(id)) ids.push_back(id);
+        }
+        return ids;
+    }
+}
+
+// every kernel must match the byte-at-a-time reference
+TEST(SimdKernelTest, ScanMatchesReference) {
+    const std::string data = randomCsvBytes(64 * 200, 42);
+
+    for (const bool has_quote : {false, true}) {
+        csv::simd::pattern pat;
+        pat.has_quote = has_quote;
+        const auto expected = referenceScan(data, pat);
+
+        for (auto id : supportedKernels()) {
+            const auto kernel = csv::simd::kernel_for(id);
+            std::vector<csv::simd::block_masks> out(expected.size());
+            const uint64_t in_quote = kernel.scan(data.data(), out.size(), pat, 0, out.data());
+
+            uint64_t quotes = 0;
+            for (size_t b = 0; b < out.size(); b++) {
+                ASSERT_EQ(out[b].sep, expected[b].sep) << kernel.name << " block " << b;
+                ASSERT_EQ(out[b].newline, expected[b].newline) << kernel.name << " block " << b;
+                ASSERT_EQ(out[b].quote, expected[b].quote) << kernel.name << " block " << b;
+                quotes += __builtin_popcountll(out[b].quote);
+            }
+            EXPECT_EQ(in_quote, quotes & 1) << kernel.name;
+            EXPECT_EQ(kernel.parity(data.data(), out.size(), pat.quote), has_quote ? (quotes & 1) : 0) << kernel.name;
+
+            uint64_t rows = 0;
+            for (const auto& m : expected) rows += __builtin_popcountll(m.newline);
+            csv::simd::newline_count counts;
+            EXPECT_EQ(kernel.count(data.data(), out.size(), pat, 0, counts), in_quote) << kernel.name;
+            EXPECT_EQ(counts.rows, rows) << kernel.name;
+            EXPECT_EQ(counts.lines, static_cast<uint64_t>(std::count(data.begin(), data.end(), '\n'))) << kernel.name;
+        }
+    }
+}
+
+// CRLF masks (kernel + resolve_crlf) and lone '\r' counts match a byte-at-a-time reference
+TEST(SimdKernelTest, CrlfMatchesReference) {
+    std::string data = randomCsvBytes(64 * 200, 7);
+    std::mt19937 rng(7);
+    for (auto& c : data) {
+        if (rng() % 8 == 0) c = '\r';
+    }
+
+    for (const bool lone_cr : {false, true}) {
+        csv::simd::pattern pat;
+        pat.has_quote = true;
+        pat.crlf = true;
+        pat.lone_cr = lone_cr;
+
+        const size_t blocks = data.size() / csv::simd::BLOCK;
+        std::vector<csv::simd::block_masks> expected(blocks, csv::simd::block_masks{0, 0, 0, 0});
+        uint64_t rows = 0, lines = 0;
+        bool in_quote = false;
+        for (size_t i = 0; i < data.size(); i++) {
+            auto& m = expected[i / csv::simd::BLOCK];
+            const uint64_t bit = 1ull << (i % csv::simd::BLOCK);
+            const char c = data[i];
+            if (c == pat.quote) {
+                m.quote |= bit;
+                in_quote = !in_quote;
+                continue;
+            }
+            const bool ends = c == '\n' || (lone_cr && c == '\r' && (i + 1 == data.size() || data[i + 1] != '\n'));
+            lines += ends;
+            if (in_quote) continue;
+            if (c == pat.delimiter) m.sep |= bit;
+            if (ends) {
+                m.sep |= bit;
+                m.newline |= bit;
+                rows++;
+            }
+            if (c == '\n' && i > 0 && data[i - 1] == '\r') m.cr |= bit;
+        }
+
+        for (auto id : supportedKernels()) {
+            const auto kernel = csv::simd::kernel_for(id);
+            std::vector<csv::simd::block_masks> out(blocks);
+            kernel.scan(data.data(), blocks, pat, 0, out.data());
+            csv::simd::resolve_crlf(out.data(), blocks, 0, 0, lone_cr);
+            for (size_t b = 0; b < blocks; b++) {
+                ASSERT_EQ(out[b].sep, expected[b].sep) << kernel.name << " block " << b;
+                ASSERT_EQ(out[b].newline, expected[b].newline) << kernel.name << " block " << b;
+                ASSERT_EQ(out[b].cr, expected[b].cr) << kernel.name << " block " << b;
+            }
+
+            // split the count in two calls, the '\r' carry crosses them
+            if (!lone_cr) continue;
+            csv::simd::newline_count counts;
+            const uint64_t in_quote_mid = kernel.count(data.data(), blocks / 2, pat, 0, counts);
+            kernel.count(data.data() + blocks / 2 * csv::simd::BLOCK, blocks - blocks / 2, pat, in_quote_mid, counts);
+            EXPECT_EQ(counts.rows, rows) << kernel.name;
+            EXPECT_EQ(counts.lines, lines) << kernel.name;
+        }
+    }
+}
+
+// quote state carried into a scan flips the first block
+TEST(SimdKernelTest, CarriedQuoteState) {
+    std::string data(64, 'x');
+    data[10] = ',';
+    data[20] = '"';
+    data[30] = ',';
+
+    csv::simd::pattern pat;
+    pat.has_quote = true;
+
+    for (auto id : supportedKernels()) {
+        const auto kernel = csv::simd::kernel_for(id);
+        csv::simd::block_masks m{};
+        EXPECT_EQ(kernel.scan(data.data(), 1, pat, 1, &m), 0u) << kernel.name;
+        EXPECT_EQ(m.sep, 1ull << 30) << kernel.name;  // comma at 10 is still inside the quote
+    }
+}
+
+TEST(SimdKernelTest, SwarEq) {
+    const char bytes[] = "a,b,,\x80\xff,";
+    uint64_t word;
+    std::memcpy(&word, bytes, 8);
+    EXPECT_EQ(csv::simd::swar_eq8(word, ','), 0b10011010u);
+    EXPECT_EQ(csv::simd::swar_eq8(word, 0xFF), 0b01000000u);
+}
+
+TEST(SimdKernelTest, ActiveKernelIsSupported) {
+    EXPECT_TRUE(csv::simd::supported(csv::simd::active().id));
+    EXPECT_TRUE(csv::simd::supported(csv::simd::isa::scalar));
+}
+
+TEST(SimdKernelTest, PrefixXor64) {
+    EXPECT_EQ(csv::simd::prefix_xor64(0), 0u);
+    EXPECT_EQ(csv::simd::prefix_xor64(1), ~0ull);
+    EXPECT_EQ(csv::simd::prefix_xor64(0b00100100), 0b00011100u);
+    EXPECT_EQ(csv::simd::prefix_xor64(1ull << 63), 1ull << 63);
+}
+
+// every kernel finds the first byte a writer must quote, at any length and offset
+TEST(SimdKernelTest, SpecialMatchesReference) {
+    const std::string data = randomCsvBytes(300, 11) + "\r";
+    for (const bool has_quote : {false, true}) {
+        csv::simd::pattern pat;
+        pat.has_quote = has_quote;
+        for (auto id : supportedKernels()) {
+            const auto kernel = csv::simd::kernel_for(id);
+            for (size_t start = 0; start < data.size(); start += 7) {
+                for (size_t size = 0; start + size <= data.size(); size += 5) {
+                    const char* p = data.data() + start;
+                    size_t expected = 0;
+                    while (expected < size && p[expected] != ',' && p[expected] != '\n' && p[expected] != '\r'
+                           && !(has_quote && p[expected] == '"')) {
+                        expected++;
+                    }
+                    ASSERT_EQ(kernel.special(p, size, pat), expected) << kernel.name << " " << start << " " << size;
+                }
+            }
+        }
+    }
+
+    // long plain runs reach the vector loops
+    const std::string plain(1000, 'x');
+    csv::simd::pattern pat;
+    for (auto id : supportedKernels()) {
+        const auto kernel = csv::simd::kernel_for(id);
+        EXPECT_EQ(kernel.special(plain.data(), plain.size(), pat), plain.size()) << kernel.name;
+        std::string tail = plain;
+        tail[999] = '\n';
+        EXPECT_EQ(kernel.special(tail.data(), tail.size(), pat), 999u) << kernel.name;
+    }
+}
@@ -0,0 +1,90 @@
+//
+// Created by lehoai on 2/17/26.
+//
+#include <gtest/gtest.h>
+#include <fstream>
+#include <filesystem>
+#include "sniff.h"
+
+namespace fs = std::filesystem;
+
+// Test a plain RFC 4180 file
+TEST(SniffTest, CommaQuotedWithHeader) {
+    const std::string sample = "id,name,price\n1,\"Smith, John\",2.5\n2,\"a \"\"b\"\"\",3\n3,c,4.25\n";
+    const csv::dialect d = csv::sniff_sample(sample);
+    EXPECT_EQ(d.format.delimiter, ',');
+    EXPECT_EQ(d.format.quote, std::optional<char>('"'));
+    EXPECT_EQ(d.format.line_ending, csv::eol::single);
+    EXPECT_EQ(d.format.new_line, '\n');
+    EXPECT_EQ(d.format.header_row, 0);
+    EXPECT_EQ(d.columns, 3);
+    EXPECT_DOUBLE_EQ(d.consistency, 1.0);
+    EXPECT_TRUE(d.header);
+}
+
+// Test a CRLF export with a preamble above the header, the sniffed format opens it
+TEST(SniffTest, SemicolonCrlfPreamble) {
+    std::string content = "Sales report\r\nGenerated 2026-02-17 10:30\r\nid;city;amount\r\n";
+    for (int i = 0; i < 200; i++) {
+        content += std::to_string(i) + ";\"city " + std::to_string(i % 7) + "\";" + std::to_string(i * 1.5) + "\r\n";
+    }
+    const auto path = (fs::temp_directory_path() / "sniff_test.csv").string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << content;
+    }
+
+    const csv::dialect d = csv::sniff(path.c_str());
+    EXPECT_EQ(d.format.delimiter, ';');
+    EXPECT_EQ(d.format.quote, std::optional<char>('"'));
+    EXPECT_EQ(d.format.line_ending, csv::eol::crlf);
+    EXPECT_EQ(d.format.header_row, 2);
+    EXPECT_EQ(d.columns, 3);
+    EXPECT_TRUE(d.header);
+
+    csv::CsvReader reader(path.c_str(), d.format);
+    EXPECT_EQ(reader.getHeaders(), (std::vector<std::string>{"id", "city", "amount"}));
+    size_t rows = 0;
+    reader.parse([&](const std::string_view* row) {
+        EXPECT_EQ(row[1], "city " + std::to_string(rows % 7));
+        rows++;
+    });
+    EXPECT_EQ(rows, 200);
+
+    // a prefix of the file: the cut row is ignored
+    const csv::dialect prefix = csv::sniff(path.c_str(), 1000);
+    EXPECT_EQ(prefix.format.delimiter, ';');
+    EXPECT_DOUBLE_EQ(prefix.consistency, 1.0);
+    fs::remove(path);
+}
+
+// Test numeric rows without a header
+TEST(SniffTest, TabNoHeader) {
+    const csv::dialect d = csv::sniff_sample("1\t2.5\t3\n4\t5\t6\n7\t8\t9");
+    EXPECT_EQ(d.format.delimiter, '\t');
+    EXPECT_EQ(d.format.quote, std::nullopt);
+    EXPECT_EQ(d.columns, 3);
+    EXPECT_FALSE(d.header);
+}
+
+// Test quoted delimiters and newlines only line up with the right quote char
+TEST(SniffTest, PipeWithQuotedDelimiters) {
+    std::string sample = "a|b|c\n";
+    for (int i = 0; i < 50; i++) {
+        sample += "x|\"it's | here\ntoo\"|" + std::to_string(i) + "\n";
+    }
+    const csv::dialect d = csv::sniff_sample(sample);
+    EXPECT_EQ(d.format.delimiter, '|');
+    EXPECT_EQ(d.format.quote, std::optional<char>('"'));
+    EXPECT_EQ(d.columns, 3);
+    EXPECT_DOUBLE_EQ(d.consistency, 1.0);
+    EXPECT_TRUE(d.header);
+}
+
+// Test lone '\r' and mixed line endings
+TEST(SniffTest, LineEndings) {
+    EXPECT_EQ(csv::sniff_sample("a,b\r1,2\r").format.new_line, '\r');
+    EXPECT_EQ(csv::sniff_sample("a,b\r1,2\r").format.line_ending, csv::eol::single);
+    EXPECT_EQ(csv::sniff_sample("a,b\r\n1,2\n3,4\r").format.line_ending, csv::eol::any);
+    EXPECT_EQ(csv::sniff_sample("").columns, 0);
+}
@@ -0,0 +1,79 @@
+//
+// Created by lehoai on 2/20/26.
+//
+#include <gtest/gtest.h>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include "csv_reader.h"
+
+namespace fs = std::filesystem;
+
+static std::string writeFile(const std::string& name, const std::string& content) {
+    const auto path = fs::temp_directory_path() / name;
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+    return path.string();
+}
+
+TEST(StatsTest, Enabled) {
+    static_assert(csv::STATS_ENABLED);
+}
+
+// rows and fields come from the masks, so projection and filters don't hide ragged rows
+TEST(StatsTest, CountsRowsFieldsAndQuotes) {
+    std::string content = "a,b,c\n1,2,3\n4,5\n6,7,8,9\n";
+    for (int i = 0; i < 1000; i++) {
+        content += "\"x,y\",2,3\n";
+    }
+    content += "10,11,12";
+    const std::string path = writeFile("csv_stats_test.csv", content);
+
+    csv::format format;
+    format.quote = '"';
+    csv::CsvReader reader(path.c_str(), format);
+    reader.select_columns(std::vector<int>{0});
+    reader.add_filter(csv::predicate::equals("a", "1"));
+    size_t delivered = 0;
+    reader.parse([&](const std::string_view*) { delivered++; });
+    EXPECT_EQ(delivered, 1);
+
+    const csv::parse_stats stats = reader.stats();
+    EXPECT_EQ(stats.bytes, content.size() - 6);
+    EXPECT_EQ(stats.rows, 1004);
+    EXPECT_EQ(stats.fields, 3 + 2 + 4 + 1000 * 3 + 3);
+    EXPECT_EQ(stats.short_rows, 1);
+    EXPECT_EQ(stats.long_rows, 1);
+    EXPECT_GT(stats.quoted_blocks, 100);
+    EXPECT_LE(stats.quoted_blocks, (stats.bytes + 63) / 64);
+    EXPECT_GT(stats.wall_ns, 0);
+    EXPECT_GT(stats.kernel_ns, 0);
+    EXPECT_LE(stats.kernel_ns + stats.callback_ns, stats.wall_ns);
+    EXPECT_GT(stats.minor_faults + stats.major_faults, 0);
+
+    // parallel chunks add up to the same counts
+    reader.reset_stats();
+    EXPECT_EQ(reader.stats().rows, 0);
+    csv::parallel_options options;
+    options.threads = 4;
+    options.chunk_size = 1024;
+    reader.parse_parallel([](unsigned, const std::string_view*) {}, options);
+    EXPECT_EQ(reader.stats().rows, 1004);
+    EXPECT_EQ(reader.stats().fields, stats.fields);
+    fs::remove(path);
+}
+
+TEST(StatsTest, CallbackTime) {
+    std::string content = "a,b\n";
+    for (int i = 0; i < 200; i++) content += "1,2\n";
+    const std::string path = writeFile("csv_stats_callback.csv", content);
+
+    csv::CsvReader reader(path.c_str(), csv::format{});
+    reader.parse([](const std::string_view*) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    });
+    const csv::parse_stats stats = reader.stats();
+    EXPECT_GE(stats.callback_ns, 200 * 50000ull);
+    EXPECT_GT(stats.callback_ns, stats.kernel_ns);
+    fs::remove(path);
+}
@@ -0,0 +1,113 @@
+//
+// Created by lehoai on 2/25/26.
+//
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "writer.h"
+
+namespace fs = std::filesystem;
+
+class WriterTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / "csv_writer_test";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+
+    static std::string slurp(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+};
+
+// Test quoting only where needed, doubled quotes, numbers and line endings
+TEST_F(WriterTest, Format) {
+    const auto path = (dir / "out.csv").string();
+    csv::format format;
+    format.quote = '"';
+    {
+        csv::CsvWriter writer(path.c_str(), format);
+        writer.write_row(std::vector<std::string>{"id", "name", "value"});
+        writer.field(1).field("plain").field(2.5).end_row();
+        writer.field(-7).field("a,b").field(int64_t{1} << 40).end_row();
+        writer.field(3u).field("say \"hi\"").field(0.1f).end_row();
+        writer.field("").field("line\nbreak").field("cr\r").end_row();
+    }
+    EXPECT_EQ(slurp(path), "id,name,value\n"
+                           "1,plain,2.5\n"
+                           "-7,\"a,b\",1099511627776\n"
+                           "3,\"say \"\"hi\"\"\",0.1\n"
+                           ",\"line\nbreak\",\"cr\r\"\n");
+
+    format.line_ending = csv::eol::crlf;
+    format.delimiter = ';';
+    csv::writer_options options;
+    options.quote_all = true;
+    {
+        csv::CsvWriter writer(path.c_str(), format, options);
+        writer.write_row(std::vector<std::string_view>{"a,b", "c"});
+        writer.field(42).end_row();
+    }
+    EXPECT_EQ(slurp(path), "\"a,b\";\"c\"\r\n42\r\n");
+
+    csv::CsvWriter unquoted(path.c_str(), csv::format{});
+    EXPECT_NO_THROW(unquoted.field("ok"));
+    EXPECT_THROW(unquoted.field("a,b"), std::invalid_argument);
+}
+
+// Test random fields survive a write and a read with unescaping, through buffer flushes and a large field
+TEST_F(WriterTest, RoundTrip) {
+    const auto path = (dir / "round.csv").string();
+    csv::format format;
+    format.quote = '"';
+    format.unescape = true;
+    format.line_ending = csv::eol::crlf;
+
+    std::mt19937 rng(7);
+    const char alphabet[] = {'a', 'b', ',', '"', '\n', ' ', '1', '\r'};
+    std::vector<std::vector<std::string>> rows;
+    for (int r = 0; r < 3000; r++) {
+        std::vector<std::string> row;
+        for (int c = 0; c < 3; c++) {
+            std::string value(rng() % 40, ' ');
+            for (auto& ch : value) ch = alphabet[rng() % sizeof(alphabet)];
+            row.push_back(value);
+        }
+        rows.push_back(row);
+    }
+    rows[1500][1] = std::string(20000, 'q') + "\"" + std::string(5000, 'z');
+
+    csv::writer_options options;
+    options.buffer_size = 4096;
+    uint64_t written = 0;
+    {
+        csv::CsvWriter writer(path.c_str(), format, options);
+        writer.write_row(std::vector<std::string>{"a", "b", "c"});
+        for (const auto& row : rows) writer.write_row(row);
+        writer.flush();
+        written = writer.bytes();
+    }
+    EXPECT_EQ(written, fs::file_size(path));
+
+    csv::CsvReader reader(path.c_str(), format);
+    std::vector<std::vector<std::string>> read;
+    reader.parse([&](const std::string_view* row) {
+        read.push_back({std::string(row[0]), std::string(row[1]), std::string(row[2])});
+    });
+    ASSERT_EQ(read.size(), rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(read[i], rows[i]) << i;
+    }
+}
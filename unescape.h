@@ -0,0 +1,109 @@
+//
+// Created by lehoai on 2/16/26.
+//
+
+#ifndef SIMDCSV_UNESCAPE_H
+#define SIMDCSV_UNESCAPE_H
+
+// RFC 4180 unescaping: "He said ""hi""" -> He said "hi"
+// the parser already has the quote mask of every block, a field holding more than its two
+// outer quotes is the only kind that needs work; all other fields stay views into the input
+// unescaped copies go to a bump arena owned by the sink and reset after every row / batch
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+    namespace detail {
+        class arena {
+        private:
+            static constexpr size_t MIN_CHUNK = 4096;
+            std::vector<std::unique_ptr<char[]>> _chunks;
+            std::vector<size_t> _sizes;   // by chunk
+            char* _current = nullptr;
+            size_t _used = 0;
+            size_t _capacity = 0;
+
+            inline void grow(size_t n);
+        public:
+            // n bytes valid until reset()
+            char* alloc(const size_t n) {
+                if (_capacity - _used < n) {
+                    grow(n);
+                }
+                char* p = _current + _used;
+                _used += n;
+                return p;
+            }
+
+            // forget every allocation, the largest chunk is kept for reuse
+            inline void reset();
+
+            // start of the chunk holding p, nullptr when p is not arena memory
+            [[nodiscard]] inline const char* chunk_of(const char* p) const;
+        };
+
+        // raw is a quoted field with doubled quotes inside, returns the unescaped copy
+        // memchr finds the quotes (vectorized by libc), the runs between them are memcpy'd
+        inline std::string_view unescape(std::string_view raw, char quote, arena& out);
+    }
+}
+
+void csv::detail::arena::grow(const size_t n) {
+    const size_t size = std::max({n, _capacity * 2, MIN_CHUNK});
+    _chunks.push_back(std::make_unique<char[]>(size));
+    _sizes.push_back(size);
+    _current = _chunks.back().get();
+    _capacity = size;
+    _used = 0;
+}
+
+void csv::detail::arena::reset() {
+    if (_chunks.size() > 1) {
+        std::swap(_chunks.front(), _chunks.back());
+        std::swap(_sizes.front(), _sizes.back());
+        _chunks.resize(1);
+        _sizes.resize(1);
+    }
+    _used = 0;
+}
+
+const char* csv::detail::arena::chunk_of(const char* p) const {
+    // a handful of chunks, they double in size
+    const auto at = reinterpret_cast<uintptr_t>(p);
+    for (size_t i = 0; i < _chunks.size(); i++) {
+        const auto start = reinterpret_cast<uintptr_t>(_chunks[i].get());
+        if (at >= start && at - start < _sizes[i]) return _chunks[i].get();
+    }
+    return nullptr;
+}
+
+std::string_view csv::detail::unescape(std::string_view raw, const char quote, arena &out) {
+    raw = raw.substr(1, raw.size() - 2);
+    char* begin = out.alloc(raw.size());
+    char* w = begin;
+    const char* p = raw.data();
+    const char* const e = p + raw.size();
+    while (p < e) {
+        const auto* q = static_cast<const char*>(std::memchr(p, quote, e - p));
+        if (q == nullptr) {
+            std::memcpy(w, p, e - p);
+            w += e - p;
+            break;
+        }
+        // keep the first quote of the pair, skip the second
+        std::memcpy(w, p, q + 1 - p);
+        w += q + 1 - p;
+        p = q + 1;
+        if (p < e && *p == quote) {
+            p++;
+        }
+    }
+    return {begin, static_cast<size_t>(w - begin)};
+}
+
+#endif //SIMDCSV_UNESCAPE_H
@@ -0,0 +1,73 @@
+//
+// Created by lehoai on 2/23/26.
+//
+
+#ifndef SIMDCSV_WATCH_H
+#define SIMDCSV_WATCH_H
+
+// wait for a file to change, used by CsvReader::follow
+// inotify on linux wakes up as soon as the file is written, elsewhere (or when inotify is not
+// available) wait() just sleeps; the caller checks the size after every wake up either way
+//
+#include <chrono>
+#include <thread>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace csv::file {
+
+    class FWatch {
+    private:
+        int fd = -1;   // inotify instance, -1 = polling
+    public:
+        explicit FWatch(const char* file_path);
+        ~FWatch();
+        FWatch(const FWatch&) = delete;
+        FWatch& operator=(const FWatch&) = delete;
+
+        // block until the file may have changed or timeout passed
+        void wait(std::chrono::milliseconds timeout);
+    };
+}
+
+#if defined(__linux__)
+inline csv::file::FWatch::FWatch(const char *file_path) {
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) return;
+    if (inotify_add_watch(fd, file_path, IN_MODIFY | IN_ATTRIB) == -1) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+inline csv::file::FWatch::~FWatch() {
+    if (fd != -1) close(fd);
+}
+
+inline void csv::file::FWatch::wait(const std::chrono::milliseconds timeout) {
+    if (fd == -1) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    pollfd p{fd, POLLIN, 0};
+    if (poll(&p, 1, static_cast<int>(timeout.count())) > 0) {
+        // drain the events, one wake up is enough
+        alignas(inotify_event) char events[4096];
+        while (read(fd, events, sizeof(events)) > 0) {}
+    }
+}
+#else
+inline csv::file::FWatch::FWatch(const char *) {}
+
+inline csv::file::FWatch::~FWatch() = default;
+
+inline void csv::file::FWatch::wait(const std::chrono::milliseconds timeout) {
+    std::this_thread::sleep_for(timeout);
+}
+#endif
+
+#endif //SIMDCSV_WATCH_H
@@ -0,0 +1,279 @@
+//
+// Created by lehoai on 2/25/26.
+//
+
+#ifndef SIMDCSV_WRITER_H
+#define SIMDCSV_WRITER_H
+
+// csv output with the reader's csv::format
+// 1. the active simd kernel finds the first byte that forces quoting, most fields are copied as is
+// 2. a quoted field is copied run by run between quote chars, each quote char is doubled
+// 3. numbers are formatted with std::to_chars straight into the buffer
+// rows go into one large aligned buffer written with write(); a field too large for the buffer
+// is written with writev() behind the buffered bytes instead of being copied
+//
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "csv_reader.h"
+#include "simd.h"
+
+namespace csv {
+
+    struct writer_options {
+        size_t buffer_size = 4 * 1024 * 1024;   // bytes buffered before a write()
+        bool quote_all = false;                 // quote every text field, not only those that need it
+    };
+
+    class CsvWriter {
+    private:
+        static constexpr size_t ALIGN = 4096;
+        static constexpr size_t NUMBER_SIZE = 32;   // longest std::to_chars output for 64-bit values
+
+        csv::format format;
+        csv::simd::pattern pat;
+        csv::simd::special_fn special;
+        std::string_view eol;
+        bool quote_all = false;
+        int fd = -1;
+        bool owns_fd = false;
+        char* _buf = nullptr;
+        size_t _capacity = 0;
+        size_t _size = 0;
+        uint64_t _written = 0;
+        bool row_open = false;   // a field was written to the current row
+
+        inline void init(const writer_options& options);
+        // write all of [data, data + size) and the buffer before it
+        inline void write_out(const char* data, size_t size);
+        inline void reserve(size_t bytes);
+        inline void separator();
+        inline void append(std::string_view text);
+        inline void append_quoted(std::string_view text);
+    public:
+        // create or truncate file_path
+        CsvWriter(const char* file_path, csv::format format, writer_options options = {});
+        // fd stays owned by the caller
+        CsvWriter(int fd, csv::format format, writer_options options = {});
+        // flushes, errors are lost: call flush() first to see them
+        ~CsvWriter();
+        CsvWriter(const CsvWriter&) = delete;
+        CsvWriter& operator=(const CsvWriter&) = delete;
+
+        // next field of the current row, quoted when it holds a delimiter, quote or line break
+        // throws std::invalid_argument when such a field meets a format without quote char
+        inline CsvWriter& field(std::string_view value);
+        CsvWriter& field(const char* value) { return field(std::string_view(value)); }
+        CsvWriter& field(const std::string& value) { return field(std::string_view(value)); }
+        // integers and floating point (shortest round trip form), never quoted
+        template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>
+                                                  && !std::is_same_v<T, char> && sizeof(T) <= 8>>
+        CsvWriter& field(T value);
+        // terminate the current row with the format's line ending
+        inline void end_row();
+
+        inline void write_row(const std::string_view* fields, size_t count);
+        inline void write_row(const std::vector<std::string>& fields);
+        inline void write_row(const std::vector<std::string_view>& fields);
+
+        // hand the buffered bytes to the kernel
+        inline void flush();
+        // bytes written so far, buffered ones included
+        [[nodiscard]] uint64_t bytes() const { return _written + _size; }
+    };
+}
+
+inline csv::CsvWriter::CsvWriter(const char *file_path, const csv::format format, const writer_options options) {
+    this->format = format;
+    fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot open file");
+    }
+    owns_fd = true;
+    try {
+        init(options);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+inline csv::CsvWriter::CsvWriter(const int fd, const csv::format format, const writer_options options) {
+    this->format = format;
+    this->fd = fd;
+    init(options);
+}
+
+inline csv::CsvWriter::~CsvWriter() {
+    try {
+        flush();
+    } catch (...) {
+    }
+    std::free(_buf);
+    if (owns_fd) close(fd);
+}
+
+void csv::CsvWriter::init(const writer_options &options) {
+    quote_all = options.quote_all;
+    pat.delimiter = format.delimiter;
+    pat.new_line = format.line_ending == csv::eol::single ? format.new_line : '\n';
+    pat.has_quote = format.quote.has_value();
+    pat.quote = format.quote.value_or('"');
+    special = csv::simd::active().special;
+    if (format.line_ending == csv::eol::crlf) eol = "\r\n";
+    else if (format.line_ending == csv::eol::any) eol = "\n";
+    else eol = std::string_view(&this->format.new_line, 1);
+
+    _capacity = (std::max<size_t>(options.buffer_size, ALIGN) + ALIGN - 1) & ~(ALIGN - 1);
+    _buf = static_cast<char *>(std::aligned_alloc(ALIGN, _capacity));
+    if (_buf == nullptr) {
+        throw std::runtime_error("Cannot allocate write buffer");
+    }
+}
+
+void csv::CsvWriter::write_out(const char *data, const size_t size) {
+    iovec parts[2] = {{_buf, _size}, {const_cast<char *>(data), size}};
+    iovec* part = parts;
+    int count = size > 0 ? 2 : 1;
+    while (count > 0) {
+        if (part->iov_len == 0) {
+            part++;
+            count--;
+            continue;
+        }
+        const ssize_t n = writev(fd, part, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Cannot write file");
+        }
+        // drop what was written, a partial write can end inside either part
+        auto left = static_cast<size_t>(n);
+        while (count > 0 && left >= part->iov_len) {
+            left -= part->iov_len;
+            part++;
+            count--;
+        }
+        if (count > 0) {
+            part->iov_base = static_cast<char *>(part->iov_base) + left;
+            part->iov_len -= left;
+        }
+    }
+    _written += _size + size;
+    _size = 0;
+}
+
+void csv::CsvWriter::reserve(const size_t bytes) {
+    if (_capacity - _size < bytes) {
+        write_out(nullptr, 0);
+    }
+}
+
+void csv::CsvWriter::separator() {
+    reserve(1);
+    if (row_open) _buf[_size++] = format.delimiter;
+    row_open = true;
+}
+
+void csv::CsvWriter::append(const std::string_view text) {
+    if (text.size() >= _capacity / 2) {
+        // large field: no copy, written right behind the buffered bytes
+        write_out(text.data(), text.size());
+        return;
+    }
+    reserve(text.size());
+    std::memcpy(_buf + _size, text.data(), text.size());
+    _size += text.size();
+}
+
+void csv::CsvWriter::append_quoted(std::string_view text) {
+    const char quote = pat.quote;
+    reserve(1);
+    _buf[_size++] = quote;
+    // runs between quote chars are copied whole, the quote char ending a run is written twice
+    while (!text.empty()) {
+        const void* found = std::memchr(text.data(), quote, text.size());
+        const size_t run = found ? static_cast<const char*>(found) - text.data() + 1 : text.size();
+        append(text.substr(0, run));
+        if (found) {
+            reserve(1);
+            _buf[_size++] = quote;
+        }
+        text.remove_prefix(run);
+    }
+    reserve(1);
+    _buf[_size++] = quote;
+}
+
+csv::CsvWriter& csv::CsvWriter::field(const std::string_view value) {
+    const bool quoted = quote_all || special(value.data(), value.size(), pat) != value.size();
+    if (!quoted && value.size() < _capacity / 2) {
+        // common case: one capacity check for the delimiter and the field
+        reserve(value.size() + 1);
+        if (row_open) _buf[_size++] = format.delimiter;
+        row_open = true;
+        std::memcpy(_buf + _size, value.data(), value.size());
+        _size += value.size();
+        return *this;
+    }
+    separator();
+    if (!quoted) {
+        append(value);
+        return *this;
+    }
+    if (!pat.has_quote) {
+        throw std::invalid_argument("Field needs quoting but the format has no quote char");
+    }
+    append_quoted(value);
+    return *this;
+}
+
+template <typename T, typename>
+csv::CsvWriter& csv::CsvWriter::field(const T value) {
+    separator();
+    reserve(NUMBER_SIZE);
+    const auto result = std::to_chars(_buf + _size, _buf + _size + NUMBER_SIZE, value);
+    _size = result.ptr - _buf;
+    return *this;
+}
+
+void csv::CsvWriter::end_row() {
+    reserve(eol.size());
+    std::memcpy(_buf + _size, eol.data(), eol.size());
+    _size += eol.size();
+    row_open = false;
+}
+
+void csv::CsvWriter::write_row(const std::string_view *fields, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        field(fields[i]);
+    }
+    end_row();
+}
+
+void csv::CsvWriter::write_row(const std::vector<std::string> &fields) {
+    for (const auto& value : fields) {
+        field(std::string_view(value));
+    }
+    end_row();
+}
+
+void csv::CsvWriter::write_row(const std::vector<std::string_view> &fields) {
+    write_row(fields.data(), fields.size());
+}
+
+void csv::CsvWriter::flush() {
+    if (_size > 0) write_out(nullptr, 0);
+}
+
+#endif //SIMDCSV_WRITER_H